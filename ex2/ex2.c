@@ -5,8 +5,84 @@ Assignment: ex2
 
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
 
-int main() {
+//Case 3
+//the biggest range the divisor sum sieve takes, the sums of its proper divisors still fit in 32 bits
+#define GENEROUS_RANGE_MAX 400000000
+
+//Case 4
+//numbers below the limit are looked up in the sieve, bigger ones are checked with Miller-Rabin
+#define SIEVE_LIMIT (1ULL << 24)
+//how many odd numbers are sieved at a time, so a segment of bits stays in the cache
+#define SIEVE_SEGMENT (1 << 18)
+//bit i is set if the odd number 2i+1 is not a prime, the sieve is built on the first query
+unsigned char* sieveBits = NULL;
+
+//Case 5
+//a number below 1000 has up to 3 digits, and after one step every 32 bit number is below 1000
+#define HAPPY_TABLE_SIZE 1000
+#define WRITER_BUFFER_SIZE (1 << 20)
+
+//collects the output and hands it to the file descriptor with one write for every full block
+//instead of one call per number (stdout has to be flushed before the writer starts)
+typedef struct BufferedWriter {
+	char data[WRITER_BUFFER_SIZE];
+	size_t used;
+	int fd;
+} BufferedWriter;
+
+//Case 6
+//a festival whose smile and cheer repeat within this many numbers is printed from a table of one period
+#define FESTIVAL_PATTERN_MAX (1 << 20)
+#define FESTIVAL_NUMBER 0
+#define FESTIVAL_SMILE 1
+#define FESTIVAL_CHEER 2
+#define FESTIVAL_BOTH 3
+
+//functions
+unsigned long long divisorSum(unsigned long long n);
+int isGenerous(unsigned long long n, unsigned long long divisors);
+int generousRange(long long limit, int countOnly);
+void buildSieve(void);
+int isPrime(unsigned long long n);
+int millerRabin(unsigned long long n);
+unsigned long long mulMod(unsigned long long a, unsigned long long b, unsigned long long m);
+unsigned long long powMod(unsigned long long base, unsigned long long exp, unsigned long long m);
+int reverseNumber(unsigned long long n, unsigned long long* reversed);
+int completesCircle(unsigned long long n);
+int circleBatch(void);
+void initHappyTables(unsigned short squares[], char happy[]);
+void printHappyNumbers(int limit);
+void writeChar(BufferedWriter* writer, char c);
+void writeNumber(BufferedWriter* writer, unsigned long long n);
+void writeBytes(BufferedWriter* writer, const char* bytes, size_t length);
+void flushWriter(BufferedWriter* writer);
+void printFestival(long long smile, long long cheer, long long maxnum);
+
+int main(int argc, char* argv[]) {
+	//"ex2 --circle" reads numbers until the end of the input and checks every one of them like option 4
+	if (argc > 1 && strcmp(argv[1], "--circle") == 0) {
+		return circleBatch();
+	}
+	//"ex2 --festival <smile> <cheer> <max>" prints only the festival sequence, like option 6
+	if (argc > 4 && strcmp(argv[1], "--festival") == 0) {
+		long long smileArg = atoll(argv[2]), cheerArg = atoll(argv[3]), maxArg = atoll(argv[4]);
+		if (smileArg == 0 || cheerArg == 0 || maxArg < 1) {
+			printf("Only 2 non zero numbers and a positive maximum number are allowed for the festival.\n");
+			return 1;
+		}
+		printFestival(smileArg, cheerArg, maxArg);
+		return 0;
+	}
+	//"ex2 --generous N [--count]" prints (or only counts) every generous number from 1 to N
+	if (argc > 2 && strcmp(argv[1], "--generous") == 0) {
+		return generousRange(atoll(argv[2]), argc > 3 && strcmp(argv[3], "--count") == 0);
+	}
 	// Case 1: Draw Happy Face with given symbols for eyes, nose and mouse
 	/* Example:
 	* n = 3:
@@ -23,14 +99,9 @@ int main() {
 	int num, temp, counter = 0;
 	int sumright = 0, sumleft = 0;
 	int skipodd = 0;;
-	//Case 3
-	int sum	= 0;
-	//Case 4
-	int reversedigit = 0, flag4 = 0;
-	//Case 5
-	int digit = 0, shownum;
 	//Case 6
-	int cheer = 0, smile = 0, maxnum;
+	int cheer = 0, smile = 0;
+	long long maxnum;
 while (flag) {
 	printf("Choose an option:\n    1. Happy Face\n    2. Balanced Number\n    3. Generous Number\n    4. Circle Of Joy\n    5. Happy Numbers \n    6. Festival Of Laughter\n    7. Exit\n");
 	scanf("%d", &option);
@@ -122,7 +193,6 @@ while (flag) {
 		}
 		case 3:
 		{
-			sum = 0;
 			printf("Enter a number:\n");
 			scanf("%d", &num);
 			while (1) {
@@ -133,12 +203,7 @@ while (flag) {
 					scanf("%d", &num);
 				}
 			}
-			for (int i = 2; i < num; i++) {
-				if (num % i == 0) {
-					sum+=i;
-				};
-			}
-			if (sum > num) {
+			if (isGenerous((unsigned long long)num, divisorSum((unsigned long long)num))) {
 				printf("This number is generous!\n");
 			} else {
 				printf("This number does not share.\n");
@@ -147,50 +212,22 @@ while (flag) {
 		}
 		case 4:
 		{
-			sum = 0, flag4 = 0, reversedigit = 0;
 			printf("Enter a number:\n");
 			scanf("%d", &num);
 			while (num < 1) {
 					printf("Only positive number is allowed, please try again:\n");
 					scanf("%d", &num);
 			}
-			for (int i = 2; i < num; i++) {
-				if (num % i == 0) {
-					printf("The circle remains incomplete.\n");
-					flag4 = 1;
-					break;
-				}
-			}
-			if (flag4 == 1) {
-				break;
-			}
-			//now we will check the reverse number
-			while (num != 0) {
-				reversedigit = num % 10;
-				num = num / 10;
-				if (num == 0) {
-					sum = (sum + reversedigit);
-				} else {
-					sum = (sum + reversedigit) * 10;
-				}
-			}
-			//now the number "sum" is reversed
-			for (int i = 2; i < sum; i++) {
-				if (sum % i == 0) {
-					printf("The circle remains incomplete.\n");
-					flag4 = 1;
-					break;
-				}
-				//printf("This number completes the circle of joy!\n");
-			}
-			if (flag4 == 0) {
+			//the number and its reverse both have to be primes
+			if (completesCircle((unsigned long long)num) == 1) {
 				printf("This number completes the circle of joy!\n");
+			} else {
+				printf("The circle remains incomplete.\n");
 			}
 			continue;
 		}
 		case 5:
 		{
-			sum = 0;
 			printf("Enter a number:\n");
 			scanf("%d", &num);
 			while (1) {
@@ -201,30 +238,7 @@ while (flag) {
 					scanf("%d", &num);
 				}
 			}
-			shownum = num;
-			//the shownum is temp for the num because we make a lot of changes to it
-			printf("Between 1 and %d only these numbers bring happiness: 1", shownum);
-			for (int i = 2; i <= shownum;i++) {
-				num = i;
-				while (1) {
-					sum = 0;
-					while(num > 0) {
-						digit = num % 10;
-						sum = sum + (digit*digit);
-						num = num / 10;
-					}
-					//the only two digits that are happy are 1 and 7 so we will check the number until it will arrive at less than 10
-					if (sum <= 9) {
-						if (sum == 1 || sum == 7) {
-							printf(" %d", i);
-							break;
-						}
-						break;
-					}
-					num = sum;
-				}
-			}
-			printf("\n");
+			printHappyNumbers(num);
 			continue;
 		}
 		case 6:
@@ -248,28 +262,16 @@ while (flag) {
 
 			//ask for the max number
 			printf("Enter maximum number for the festival:\n");
-			scanf("%d", &maxnum);
+			scanf("%lld", &maxnum);
 			while (1) {
 				if (maxnum >= 1) {
 					break;
 				} else {
 					printf("Only positive maximum number is allowed, please try again:\n");
-					scanf("%d", &maxnum);
-				}
-			}
-			for (int i = 1; i <= maxnum; i++) {
-				if (i % cheer == 0 && i % smile == 0) {
-					printf("Festival!\n");
-				}
-				else if (i % cheer == 0) {
-					printf("Cheer!\n");
-				}
-				else if (i % smile == 0) {
-					printf("Smile!\n");
-				} else {
-					printf("%d\n", i);
+					scanf("%lld", &maxnum);
 				}
 			}
+			printFestival(smile, cheer, maxnum);
 			//does not require continue but just for uniformity
 			continue;
 		}
@@ -329,5 +331,470 @@ while (flag) {
 	/* Example:
 	6, smile: 2, cheer: 3 : 1, Smile!, Cheer!, Smile!, 5, Festival!
 	*/
+	free(sieveBits);
 	return 0;
 };
+
+//the sum of all the divisors of n (n itself and 1 included), the divisors come in pairs d and n/d
+//so they are all found up to the square root, and every prime factor found is divided out of n
+unsigned long long divisorSum(unsigned long long n) {
+	unsigned long long sum = 1;
+	for (unsigned long long p = 2; p * p <= n; p += (p == 2 ? 1 : 2)) {
+		if (n % p != 0) {
+			continue;
+		}
+		//for p^k the divisors are 1 + p + ... + p^k
+		unsigned long long power = 1, powersSum = 1;
+		while (n % p == 0) {
+			n /= p;
+			power *= p;
+			powersSum += power;
+		}
+		sum *= powersSum;
+	}
+	//what is left is 1 or a prime bigger than the square root
+	if (n > 1) {
+		sum *= n + 1;
+	}
+	return sum;
+}
+
+//a number is generous when its divisors between 2 and n-1 add up to more than n
+int isGenerous(unsigned long long n, unsigned long long divisors) {
+	return n > 1 && divisors - n - 1 > n;
+}
+
+//a linear sieve - every n is reached once, as its smallest prime p times n/p.
+//the divisor sum is multiplicative, so next to it we keep powersSum[n] = 1 + p + ... + p^k for the
+//power of the smallest prime in n, and multiplying by p again only replaces that one factor.
+//the sums of the whole range fit in 32 bits up to GENEROUS_RANGE_MAX
+int generousRange(long long limit, int countOnly) {
+	if (limit < 1 || limit > GENEROUS_RANGE_MAX) {
+		printf("The range must be between 1 and %d.\n", GENEROUS_RANGE_MAX);
+		return 1;
+	}
+	unsigned int* divisors = (unsigned int*)calloc((size_t)limit + 1, sizeof(unsigned int));
+	unsigned int* powersSum = (unsigned int*)calloc((size_t)limit + 1, sizeof(unsigned int));
+	size_t primesCount = 0, primesSize = 1024;
+	unsigned int* primes = (unsigned int*)malloc(primesSize * sizeof(unsigned int));
+	if (divisors == NULL || powersSum == NULL || primes == NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	static char outputBuffer[1 << 16];
+	setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+	long long count = 0;
+	divisors[1] = 1;
+	powersSum[1] = 1;
+	for (unsigned int n = 2; n <= limit; n++) {
+		//nothing reached n so it is a prime
+		if (divisors[n] == 0) {
+			divisors[n] = n + 1;
+			powersSum[n] = n + 1;
+			if (primesCount == primesSize) {
+				primesSize *= 2;
+				unsigned int* bigger = (unsigned int*)realloc(primes, primesSize * sizeof(unsigned int));
+				if (bigger == NULL) {
+					printf("Memory allocation error\n");
+					exit(1);
+				}
+				primes = bigger;
+			}
+			primes[primesCount++] = n;
+		}
+		for (size_t i = 0; i < primesCount && (long long)n * primes[i] <= limit; i++) {
+			unsigned int p = primes[i], multiple = n * p;
+			if (n % p == 0) {
+				powersSum[multiple] = powersSum[n] * p + 1;
+				divisors[multiple] = divisors[n] / powersSum[n] * powersSum[multiple];
+				//p is the smallest prime of n, so a bigger prime times n is not reached from here
+				break;
+			}
+			powersSum[multiple] = p + 1;
+			divisors[multiple] = divisors[n] * (p + 1);
+		}
+		if (isGenerous(n, divisors[n])) {
+			count++;
+			if (!countOnly) {
+				printf("%u\n", n);
+			}
+		}
+	}
+	printf("Between 1 and %lld there are %lld generous numbers.\n", limit, count);
+	fflush(stdout);
+	free(divisors);
+	free(powersSum);
+	free(primes);
+	return 0;
+}
+
+//squares[i] - the sum of the squared digits of i (i < 1000)
+//happy[s] - 1 if a number whose digits' squares add up to s is happy.
+//the chain is followed until it is below 10, where the only happy ones are 1 and 7
+void initHappyTables(unsigned short squares[], char happy[]) {
+	for (int i = 0; i < HAPPY_TABLE_SIZE; i++) {
+		int digit = i % 10;
+		squares[i] = (unsigned short)(digit * digit + (i >= 10 ? squares[i / 10] : 0));
+	}
+	for (int i = 0; i < HAPPY_TABLE_SIZE; i++) {
+		int sum = i;
+		while (sum > 9) {
+			sum = squares[sum];
+		}
+		happy[i] = (char)(sum == 1 || sum == 7);
+	}
+}
+
+//the numbers are walked 1000 at a time - the squares of the high digits are added once for every
+//block and every number only adds its low 3 digits and looks the sum up
+void printHappyNumbers(int limit) {
+	static unsigned short squares[HAPPY_TABLE_SIZE];
+	static char happy[HAPPY_TABLE_SIZE];
+	static BufferedWriter writer;
+	initHappyTables(squares, happy);
+	printf("Between 1 and %d only these numbers bring happiness: 1", limit);
+	fflush(stdout);
+	writer.used = 0;
+	writer.fd = STDOUT_FILENO;
+	for (int high = 0; high <= limit / HAPPY_TABLE_SIZE; high++) {
+		int highSum = squares[high % 1000] + squares[high / 1000 % 1000] + squares[high / 1000000];
+		int base = high * HAPPY_TABLE_SIZE;
+		int last = limit - base < HAPPY_TABLE_SIZE - 1 ? limit - base : HAPPY_TABLE_SIZE - 1;
+		//1 is already printed
+		for (int low = (high == 0 ? 2 : 0); low <= last; low++) {
+			if (happy[highSum + squares[low]]) {
+				writeChar(&writer, ' ');
+				writeNumber(&writer, (unsigned long long)(base + low));
+			}
+		}
+	}
+	writeChar(&writer, '\n');
+	flushWriter(&writer);
+}
+
+void writeChar(BufferedWriter* writer, char c) {
+	if (writer->used == WRITER_BUFFER_SIZE) {
+		flushWriter(writer);
+	}
+	writer->data[writer->used++] = c;
+}
+
+void writeNumber(BufferedWriter* writer, unsigned long long n) {
+	//the digits come out from the last one so they are reversed into place
+	char digits[20];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + n % 10);
+		n /= 10;
+	} while (n != 0);
+	if (writer->used + count > WRITER_BUFFER_SIZE) {
+		flushWriter(writer);
+	}
+	while (count > 0) {
+		writer->data[writer->used++] = digits[--count];
+	}
+}
+
+void writeBytes(BufferedWriter* writer, const char* bytes, size_t length) {
+	if (writer->used + length > WRITER_BUFFER_SIZE) {
+		flushWriter(writer);
+	}
+	memcpy(writer->data + writer->used, bytes, length);
+	writer->used += length;
+}
+
+void flushWriter(BufferedWriter* writer) {
+	size_t written = 0;
+	//write can take only a part of the block (a pipe that is full), so we keep going until it is all out
+	while (written < writer->used) {
+		ssize_t result = write(writer->fd, writer->data + written, writer->used - written);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			//the reader is gone, there is nobody to write to
+			break;
+		}
+		written += (size_t)result;
+	}
+	writer->used = 0;
+}
+
+//every number from 1 to maxnum is a word if smile or cheer divides it, and the number itself if not.
+//which one it is repeats every lcm(smile, cheer) numbers, so for a short period the answer is looked up
+//in a table of one period, and for a long one two countdowns say when the next smile and cheer come.
+//the number is kept as a decimal string that is increased in place, without dividing it into digits
+void printFestival(long long smile, long long cheer, long long maxnum) {
+	static BufferedWriter writer;
+	static const char* words[] = {"", "Smile!\n", "Cheer!\n", "Festival!\n"};
+	static const size_t wordsLength[] = {0, 7, 7, 10};
+	//the sign does not change what divides a number
+	unsigned long long smileStep = smile < 0 ? 0 - (unsigned long long)smile : (unsigned long long)smile;
+	unsigned long long cheerStep = cheer < 0 ? 0 - (unsigned long long)cheer : (unsigned long long)cheer;
+	//a 0 never divides anything, its countdown is longer than any festival
+	if (smileStep == 0) {
+		smileStep = ULLONG_MAX;
+	}
+	if (cheerStep == 0) {
+		cheerStep = ULLONG_MAX;
+	}
+	unsigned long long a = smileStep, b = cheerStep;
+	while (b != 0) {
+		unsigned long long rest = a % b;
+		a = b;
+		b = rest;
+	}
+	unsigned long long period = 0;
+	if (smileStep / a <= FESTIVAL_PATTERN_MAX / cheerStep) {
+		period = smileStep / a * cheerStep;
+	}
+	//pattern[i % period] - what number i is
+	char* pattern = NULL;
+	if (period != 0) {
+		pattern = (char*)malloc((size_t)period);
+		if (pattern == NULL) {
+			printf("Memory allocation error\n");
+			exit(1);
+		}
+		for (unsigned long long i = 0; i < period; i++) {
+			pattern[i] = (char)((i % smileStep == 0 ? FESTIVAL_SMILE : 0) | (i % cheerStep == 0 ? FESTIVAL_CHEER : 0));
+		}
+	}
+	//the digits of the current number are decimal[first] up to the end
+	char decimal[24];
+	int end = (int)sizeof(decimal), first = end - 1;
+	decimal[first] = '0';
+	unsigned long long place = 0, smileLeft = smileStep, cheerLeft = cheerStep;
+	fflush(stdout);
+	writer.used = 0;
+	writer.fd = STDOUT_FILENO;
+	for (long long i = 1; i <= maxnum; i++) {
+		int at = end - 1;
+		while (at >= first && decimal[at] == '9') {
+			decimal[at--] = '0';
+		}
+		if (at < first) {
+			first = at;
+			decimal[at] = '1';
+		} else {
+			decimal[at]++;
+		}
+		int kind;
+		if (pattern != NULL) {
+			if (++place == period) {
+				place = 0;
+			}
+			kind = pattern[place];
+		} else {
+			kind = 0;
+			if (--smileLeft == 0) {
+				smileLeft = smileStep;
+				kind |= FESTIVAL_SMILE;
+			}
+			if (--cheerLeft == 0) {
+				cheerLeft = cheerStep;
+				kind |= FESTIVAL_CHEER;
+			}
+		}
+		if (kind == FESTIVAL_NUMBER) {
+			if (writer.used + (size_t)(end - first) + 1 > WRITER_BUFFER_SIZE) {
+				flushWriter(&writer);
+			}
+			memcpy(writer.data + writer.used, decimal + first, (size_t)(end - first));
+			writer.used += (size_t)(end - first);
+			writer.data[writer.used++] = '\n';
+		} else {
+			writeBytes(&writer, words[kind], wordsLength[kind]);
+		}
+	}
+	flushWriter(&writer);
+	free(pattern);
+}
+
+//the sieve keeps only the odd numbers, one bit each, and is filled one segment at a time
+//with the odd primes up to the square root of the limit
+void buildSieve(void) {
+	unsigned long long count = SIEVE_LIMIT / 2;
+	sieveBits = (unsigned char*)calloc(count / 8 + 1, 1);
+	unsigned int root = 1;
+	while ((unsigned long long)(root + 1) * (root + 1) < SIEVE_LIMIT) {
+		root++;
+	}
+	//small[i] is 1 if i is not a prime
+	char* small = (char*)calloc(root + 1, 1);
+	if (sieveBits == NULL || small == NULL) {
+		printf("Memory allocation error\n");
+		exit(1);
+	}
+	for (unsigned int i = 3; i * i <= root; i += 2) {
+		if (!small[i]) {
+			for (unsigned int j = i * i; j <= root; j += 2 * i) {
+				small[j] = 1;
+			}
+		}
+	}
+	//1 is not a prime
+	sieveBits[0] |= 1;
+	for (unsigned long long low = 0; low < count; low += SIEVE_SEGMENT) {
+		unsigned long long high = low + SIEVE_SEGMENT < count ? low + SIEVE_SEGMENT : count;
+		unsigned long long lowNum = 2 * low + 1;
+		for (unsigned int p = 3; p <= root; p += 2) {
+			if (small[p]) {
+				continue;
+			}
+			//the first odd multiple of p in the segment, the smaller multiples have smaller factors
+			unsigned long long start = (unsigned long long)p * p;
+			if (start < lowNum) {
+				start = (lowNum + p - 1) / p * p;
+				if (start % 2 == 0) {
+					start += p;
+				}
+			}
+			//the next odd multiple is 2p further, which is p bits further
+			for (unsigned long long i = start / 2; i < high; i += p) {
+				sieveBits[i / 8] |= (unsigned char)(1 << (i % 8));
+			}
+		}
+	}
+	free(small);
+}
+
+int isPrime(unsigned long long n) {
+	if (n < 2) {
+		return 0;
+	}
+	if (n % 2 == 0) {
+		return n == 2;
+	}
+	if (n < SIEVE_LIMIT) {
+		if (sieveBits == NULL) {
+			buildSieve();
+		}
+		return !(sieveBits[n / 16] & (1 << (n / 2 % 8)));
+	}
+	return millerRabin(n);
+}
+
+//these bases give the right answer for every 64 bit number, so the test is deterministic
+int millerRabin(unsigned long long n) {
+	static const unsigned long long bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+	int basesCount = (int)(sizeof(bases) / sizeof(bases[0]));
+	//n-1 = d * 2^r with an odd d
+	unsigned long long d = n - 1;
+	int r = 0;
+	while (d % 2 == 0) {
+		d /= 2;
+		r++;
+	}
+	for (int i = 0; i < basesCount; i++) {
+		if (bases[i] % n == 0) {
+			return 1;
+		}
+		unsigned long long x = powMod(bases[i], d, n);
+		if (x == 1 || x == n - 1) {
+			continue;
+		}
+		int witness = 1;
+		for (int j = 1; j < r; j++) {
+			x = mulMod(x, x, n);
+			if (x == n - 1) {
+				witness = 0;
+				break;
+			}
+		}
+		if (witness) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+unsigned long long mulMod(unsigned long long a, unsigned long long b, unsigned long long m) {
+#ifdef __SIZEOF_INT128__
+	return (unsigned long long)((unsigned __int128)a * b % m);
+#else
+	//without 128 bit numbers we multiply by doubling, no step goes over m twice so nothing overflows
+	unsigned long long result = 0;
+	a %= m;
+	while (b > 0) {
+		if (b & 1) {
+			result = result >= m - a ? result - (m - a) : result + a;
+		}
+		a = a >= m - a ? a - (m - a) : a + a;
+		b >>= 1;
+	}
+	return result;
+#endif
+}
+
+unsigned long long powMod(unsigned long long base, unsigned long long exp, unsigned long long m) {
+	unsigned long long result = 1;
+	base %= m;
+	while (exp > 0) {
+		if (exp & 1) {
+			result = mulMod(result, base, m);
+		}
+		base = mulMod(base, base, m);
+		exp >>= 1;
+	}
+	return result;
+}
+
+//returns 0 if the reversed number does not fit in 64 bits
+int reverseNumber(unsigned long long n, unsigned long long* reversed) {
+	unsigned long long sum = 0;
+	while (n != 0) {
+		unsigned long long digit = n % 10;
+		if (sum > (ULLONG_MAX - digit) / 10) {
+			return 0;
+		}
+		sum = sum * 10 + digit;
+		n /= 10;
+	}
+	*reversed = sum;
+	return 1;
+}
+
+//1 if the number and its reverse are primes, 0 if not and -1 if the reverse is too big to check.
+//1 has no divisors to find either, so it completes the circle too
+int completesCircle(unsigned long long n) {
+	unsigned long long reversed;
+	if (n == 1) {
+		return 1;
+	}
+	if (!isPrime(n)) {
+		return 0;
+	}
+	if (!reverseNumber(n, &reversed)) {
+		return -1;
+	}
+	return isPrime(reversed);
+}
+
+//the input is a list of positive numbers separated by white space,
+//every number gets its own line of output
+int circleBatch(void) {
+	char token[32];
+	static char outputBuffer[1 << 16];
+	setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+	while (scanf(" %31s", token) == 1) {
+		char* end;
+		errno = 0;
+		unsigned long long n = strtoull(token, &end, 10);
+		if (token[0] == '-' || *end != '\0' || n == 0 || errno == ERANGE) {
+			printf("%s: Only positive number is allowed.\n", token);
+			continue;
+		}
+		int verdict = completesCircle(n);
+		if (verdict == 1) {
+			printf("%llu: This number completes the circle of joy!\n", n);
+		} else if (verdict == 0) {
+			printf("%llu: The circle remains incomplete.\n", n);
+		} else {
+			printf("%llu: The reversed number is too big to check.\n", n);
+		}
+	}
+	fflush(stdout);
+	free(sieveBits);
+	return 0;
+}
@@ -4,7 +4,24 @@ ID:212730311
 Assignment: ex3
 *******************/
 
+//for clock_gettime
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+//the range scans run on threads, build with -pthread
+#include <pthread.h>
+//the vector kernels are built for x86 with gcc or clang and picked at run time by what the cpu has
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define CUBE_SIMD 1
+#endif
 
 
 #define NUM_OF_BRANDS 5
@@ -23,35 +40,262 @@ char types[NUM_OF_TYPES][TYPES_NAMES] = {"SUV", "Sedan", "Coupe", "GT"};
 #define insights 5
 #define deltas 6
 #define done 7
+#define rangeStats 8
+
+//every part of the cube's block starts on its own cache line
+#define CUBE_ALIGN 64
+#define BITS_IN_WORD 64
+
+//the cube is kept by columns - all the days of one brand and type are next to each other,
+//so a sum over days is one straight run over memory.
+//an empty cell is 0 and the days that have data are marked in a separate bitmap
+typedef struct SalesCube {
+    int days, brands, types;
+    //sales[(brand * types + type) * days + day]
+    int* sales;
+    //bit (brand % 64) of present[day * presentWords + brand / 64] is set if the brand has data for the day
+    unsigned long long* present;
+    int presentWords;
+    char (*brandNames)[BRANDS_NAMES];
+    char (*typeNames)[TYPES_NAMES];
+    //the totals are kept up to date by Insert_Type_For_Brand, so the stats never scan the cube:
+    //brandDaySales[brand * days + day] and typeDaySales[type * days + day] - the sales of one day
+    int* brandDaySales;
+    int* typeDaySales;
+    //daySales[day] - the sales of all the brands in the day
+    long long* daySales;
+    //brandTotals[brand] and typeTotals[type] - the sales of all the days
+    long long* brandTotals;
+    long long* typeTotals;
+    //Fenwick trees over the days of every brand, every type and all of them together,
+    //the sales of any range of days take O(log days)
+    long long* brandFenwick;
+    long long* typeFenwick;
+    long long* dayFenwick;
+    //all the arrays above are parts of this one block
+    char* block;
+    //the most profitable day, -1 if there is no data and -2 if it has to be searched again
+    int bestDay;
+    //a cube that is kept in a snapshot file has its block mapped right after the file's header,
+    //snapshot is NULL for a cube on the heap
+    struct SnapshotHeader* snapshot;
+    size_t snapshotSize;
+    int snapshotFd;
+    char* snapshotPath;
+} SalesCube;
+
+#define CUBE_CELL(cube, day, brand, type) \
+    ((cube)->sales[((size_t)(brand) * (cube)->types + (type)) * (cube)->days + (day)])
+
+//the loops that scan the columns, an empty cell is 0 so none of them has to check for it
+typedef struct CubeKernels {
+    const char* name;
+    //the sum of count days of a column
+    long long (*sumColumn)(const int* column, int count);
+    //totals[i] += column[i] for count days
+    void (*addColumn)(long long* totals, const int* column, int count);
+} CubeKernels;
+
+CubeKernels scalarKernels;
+#ifdef CUBE_SIMD
+CubeKernels sse2Kernels, avx2Kernels;
+#endif
+//the kernels the scans use, the best ones this cpu can run
+CubeKernels kernels;
+
+#define BENCH_DAYS 3650
+#define BENCH_BRANDS 500
+#define BENCH_ROUNDS 5
+//the scaling benchmark's default cube - ten years of a couple thousand brands
+#define SCALE_DAYS 3650
+#define SCALE_BRANDS 2000
+#define MAX_THREADS 256
+
+//the sums of a range of days found by scanning the cube
+typedef struct RangeStats {
+    //brandTotals[brand] and typeTotals[type] - the sales in the range
+    long long* brandTotals;
+    long long* typeTotals;
+    //brandFirst[brand] and brandLast[brand] - the sales of the first and the last day of the range
+    long long* brandFirst;
+    long long* brandLast;
+    long long total;
+    //the first day with the most sales out of the days with data, -1 if no day in the range has data
+    int bestDay;
+    long long bestDaySales;
+} RangeStats;
+
+//the days one thread scans and what it found in them
+typedef struct RangeChunk {
+    const SalesCube* cube;
+    const CubeKernels* use;
+    int from, to;
+    //room for the sales of every day of the chunk
+    long long* dayTotals;
+    RangeStats partial;
+} RangeChunk;
+
+//how many threads the menu's insights, deltas and range stats scan the cube with,
+//0 answers them from the kept totals
+int scanThreads = 0;
+
+//a binary rows file starts with this and then has 4 ints (day, brand, type, sales) for every row,
+//in the byte order of the machine that wrote it
+#define ROWS_MAGIC "EX3ROWS\n"
+#define ROWS_MAGIC_SIZE 8
+#define ROW_FIELDS 4
+//a row after the end of the cube and after this day is rejected, so one bad row can not grow the cube past the memory
+#define MAX_LOAD_DAYS (100 * DAYS_IN_YEAR)
+
+//a snapshot file is this header and then the cube's block just like Cube_Layout places it, in the byte order
+//of the machine that wrote it. the header takes one cache line so the block in the mapped file stays aligned.
+//a cube that grows is written whole to path + SNAPSHOT_GROWING and renamed over the old file
+#define SNAPSHOT_MAGIC "EX3SNAP\n"
+#define SNAPSHOT_GROWING ".growing"
+#define SNAPSHOT_MAGIC_SIZE 8
+#define SNAPSHOT_VERSION 1
+typedef struct SnapshotHeader {
+    char magic[SNAPSHOT_MAGIC_SIZE];
+    long long blockSize;
+    int version;
+    int days, brands, types;
+    //the days that were populated, where the menu goes on from
+    int filledDays;
+    char reserved[CUBE_ALIGN - SNAPSHOT_MAGIC_SIZE - sizeof(long long) - 5 * sizeof(int)];
+} SnapshotHeader;
 
 void printMenu();
-int If_Brand_Value(int day, int brand, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int TYPES_SIZE);
-void Insert_Type_For_Brand(int day, int brandchoice, int suvchoice, int sedanchoice, int coupechoice, int gtchoice,
-    int cube[][NUM_OF_BRANDS][NUM_OF_TYPES]);
-int Brand_Sum_Sales(int day, int brandchoice, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int TYPES_SIZE);
-int Best_Brand_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE, int TYPES_SIZE);
-int Type_Sum_Sales(int day, int type, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE);
-int Best_Type_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE, int TYPES_SIZE);
-int All_Brands_Day_Sum_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE, int TYPES_SIZE);
-double Delta_Average(int brand, int currentday, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int TYPES_SIZE);
-
-
-int main() {
-    int cube[DAYS_IN_YEAR][NUM_OF_BRANDS][NUM_OF_TYPES];//365*5*4
+SalesCube* Create_Cube(int days, int brandsCount, int typesCount);
+size_t Cube_Layout(SalesCube* cube, char* block);
+void* Layout_Part(char* block, size_t* offset, size_t size);
+void Copy_Columns(void* to, const void* from, size_t columns, int toDays, int fromDays, size_t cellSize);
+void Grow_Cube(SalesCube* cube, int days);
+void Free_Cube(SalesCube* cube);
+int If_Brand_Value(const SalesCube* cube, int day, int brand);
+int If_Day_Value(const SalesCube* cube, int day);
+void Insert_Type_For_Brand(SalesCube* cube, int day, int brandchoice, const int sales[]);
+int Brand_Sum_Sales(const SalesCube* cube, int day, int brandchoice);
+int Best_Brand_Sales(const SalesCube* cube, int day);
+int Type_Sum_Sales(const SalesCube* cube, int day, int type);
+int Best_Type_Sales(const SalesCube* cube, int day);
+int Best_Brand_Overall(const SalesCube* cube);
+int Best_Type_Overall(const SalesCube* cube);
+int Most_Profitable_Day(SalesCube* cube);
+double Delta_Average(const SalesCube* cube, int brand, int currentday);
+void Fenwick_Add(long long tree[], int size, int day, long long delta);
+long long Fenwick_Prefix(const long long tree[], int day);
+void Fenwick_Build(long long tree[], int size);
+long long Brand_Range_Sales(const SalesCube* cube, int brand, int from, int to);
+long long Type_Range_Sales(const SalesCube* cube, int type, int from, int to);
+long long Range_Sales(const SalesCube* cube, int from, int to);
+double Brand_Range_Delta(const SalesCube* cube, int brand, int from, int to);
+void Select_Kernels();
+long long Sum_Column_Scalar(const int* column, int count);
+void Add_Column_Scalar(long long* totals, const int* column, int count);
+#ifdef CUBE_SIMD
+long long Sum_Column_Sse2(const int* column, int count);
+void Add_Column_Sse2(long long* totals, const int* column, int count);
+long long Sum_Column_Avx2(const int* column, int count);
+void Add_Column_Avx2(long long* totals, const int* column, int count);
+#endif
+void Scan_Day_Totals(const SalesCube* cube, const CubeKernels* use, int from, int to, long long totals[]);
+void Scan_Brand_Totals(const SalesCube* cube, const CubeKernels* use, int from, int to, long long totals[]);
+void Scan_Type_Totals(const SalesCube* cube, const CubeKernels* use, int from, int to, long long totals[]);
+int Scan_Best_Brand(const SalesCube* cube, const CubeKernels* use, int from, int to);
+int Scan_Best_Type(const SalesCube* cube, const CubeKernels* use, int from, int to);
+int Best_Of(const long long totals[], int count);
+double Seconds_Now();
+int Run_Bench(int days, int brandsCount, int typesCount);
+void Alloc_Range_Stats(RangeStats* result, int brandsCount, int typesCount);
+void Free_Range_Stats(RangeStats* result);
+void* Scan_Range_Chunk(void* arg);
+void Parallel_Range_Stats(const SalesCube* cube, int from, int to, int threads, RangeStats* result);
+int Online_Cores();
+int Run_Scale_Bench(int days, int brandsCount, int typesCount, int maxThreads);
+int Load_Rows(SalesCube* cube, const char* path, int* lastDay);
+int Load_Row(SalesCube* cube, int day, int brand, int type, int sales);
+const char* Parse_Number(const char* at, const char* end, int* number);
+SalesCube* Open_Snapshot(const char* path, int* filledDays);
+int Create_Snapshot(SalesCube* cube, const char* path, int filledDays);
+int Map_Snapshot(SalesCube* cube, size_t size);
+void Close_Snapshot(SalesCube* cube, int filledDays);
+int Replace_Snapshot(SalesCube* grown, const SnapshotHeader* header, const char* heapBlock, size_t blockSize);
+char* Copy_Path(const char* path, const char* suffix);
+
+
+int main(int argc, char* argv[]) {
+    Select_Kernels();
+    //"ex3 --bench [days brands types]" times the scanning kernels on a random cube
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        if (argc > 4) {
+            return Run_Bench(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+        }
+        return Run_Bench(BENCH_DAYS, BENCH_BRANDS, NUM_OF_TYPES);
+    }
+    //"ex3 --scale [days brands types [threads]]" times the parallel range scan with 1 thread up to all the cores
+    if (argc > 1 && strcmp(argv[1], "--scale") == 0) {
+        if (argc > 4) {
+            return Run_Scale_Bench(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]),
+                argc > 5 ? atoi(argv[5]) : Online_Cores());
+        }
+        return Run_Scale_Bench(SCALE_DAYS, SCALE_BRANDS, NUM_OF_TYPES, Online_Cores());
+    }
+    //"ex3 --cube <days> <brands> <types>" starts with a cube of another size, the extra brands and types
+    //get numbered names
+    //"ex3 --load <file>" fills the cube from a csv or binary rows file before the menu starts
+    //"ex3 --snapshot <file>" keeps the cube in a file - an existing snapshot is opened with its own size and
+    //the menu goes on from its last day, otherwise the new cube (after any --load) is written to the file
+    //"ex3 --threads <n>" answers insights, deltas and range stats by scanning the cube on n threads
+    int cubeDays = DAYS_IN_YEAR, cubeBrands = NUM_OF_BRANDS, cubeTypes = NUM_OF_TYPES;
+    const char* loadPath = NULL;
+    const char* snapshotPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (i + 3 < argc && strcmp(argv[i], "--cube") == 0) {
+            cubeDays = atoi(argv[i+1]);
+            cubeBrands = atoi(argv[i+2]);
+            cubeTypes = atoi(argv[i+3]);
+            i += 3;
+        } else if (i + 1 < argc && strcmp(argv[i], "--load") == 0) {
+            loadPath = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--snapshot") == 0) {
+            snapshotPath = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0) {
+            scanThreads = atoi(argv[++i]);
+            scanThreads = scanThreads < 0 ? 0 : scanThreads > MAX_THREADS ? MAX_THREADS : scanThreads;
+        }
+    }
+    if (cubeDays < 1 || cubeBrands < 1 || cubeTypes < 1) {
+        printf("The cube needs at least one day, brand and type\n");
+        return 1;
+    }
+    SalesCube* cube;
     int choice;
     int day = 0, sum = 0;
+    if (snapshotPath != NULL && access(snapshotPath, F_OK) == 0) {
+        cube = Open_Snapshot(snapshotPath, &day);
+        if (cube == NULL) {
+            return 1;
+        }
+    } else {
+        cube = Create_Cube(cubeDays, cubeBrands, cubeTypes);
+    }
+    //the loaded days count as populated, like days entered with option 2
+    if (loadPath != NULL && !Load_Rows(cube, loadPath, &day)) {
+        Free_Cube(cube);
+        return 1;
+    }
+    if (snapshotPath != NULL && cube->snapshot == NULL && !Create_Snapshot(cube, snapshotPath, day)) {
+        Free_Cube(cube);
+        return 1;
+    }
     int counter;
     int daychoice;
     //integers for case 1 and 2 use of choices
-    int brandchoice, suvchoice, sedanchoice, coupechoice, gtchoice;
-
-    //set cube to -1
-    for (int i = 0; i < DAYS_IN_YEAR; i++) {
-        for (int j = 0; j < NUM_OF_BRANDS; j++) {
-            for (int w = 0; w < NUM_OF_TYPES; w++) {
-                cube[i][j][w] = -1;
-            }
-        }
+    int brandchoice;
+    int* typeschoice = (int*)malloc((size_t)cube->types * sizeof(int));
+    if (typeschoice == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
     }
 
     //first print
@@ -65,29 +309,50 @@ int main() {
         {
             case addOne:
             {
-                printf("Enter Brand by index and 4 integers for SUV, Sedan, Coupe, GT: \n");
-                scanf("%d %d %d %d %d", &brandchoice, &suvchoice, &sedanchoice, &coupechoice, &gtchoice);
-                if (brandchoice < 0 || brandchoice > 4) {
+                printf("Enter Brand by index and %d integers for ", cube->types);
+                for (int i = 0; i < cube->types; i++) {
+                    printf(i == 0 ? "%s" : ", %s", cube->typeNames[i]);
+                }
+                printf(": \n");
+                scanf("%d", &brandchoice);
+                for (int i = 0; i < cube->types; i++) {
+                    scanf("%d", &typeschoice[i]);
+                }
+                if (brandchoice < 0 || brandchoice >= cube->brands) {
                     printf("This brand is not valid\n");
-                    printf("Enter Brand by index and 4 integers for SUV, Sedan, Coupe, GT: ");
-                    scanf("%d %d %d %d %d", &brandchoice, &suvchoice, &sedanchoice, &coupechoice, &gtchoice);
+                    printf("Enter Brand by index and %d integers for ", cube->types);
+                    for (int i = 0; i < cube->types; i++) {
+                        printf(i == 0 ? "%s" : ", %s", cube->typeNames[i]);
+                    }
+                    printf(": ");
+                    scanf("%d", &brandchoice);
+                    for (int i = 0; i < cube->types; i++) {
+                        scanf("%d", &typeschoice[i]);
+                    }
+                    if (brandchoice < 0 || brandchoice >= cube->brands) {
+                        break;
+                    }
                 }
-                cube[day+1][brandchoice][0] = suvchoice;
-                cube[day+1][brandchoice][1] = sedanchoice;
-                cube[day+1][brandchoice][2] = coupechoice;
-                cube[day+1][brandchoice][3] = gtchoice;
+                //the data goes to the day after the current one
+                if (day + 1 >= cube->days) {
+                    Grow_Cube(cube, 2 * (day + 1));
+                }
+                Insert_Type_For_Brand(cube, day+1, brandchoice, typeschoice);
                 break;
             }
             case addAll:
             {
+                if (day >= cube->days) {
+                    Grow_Cube(cube, 2 * day);
+                }
                 counter = 0;
-                while(counter < 4)
+                while(counter < cube->brands - 1)
                 {
                     counter = 0;
                     printf("No data for brands ");
-                    for (int i = 0; i < NUM_OF_BRANDS; i++) {
-                        if (!If_Brand_Value(day, i, cube, NUM_OF_TYPES)) {
-                            printf("%s ",brands[i]);
+                    for (int i = 0; i < cube->brands; i++) {
+                        if (!If_Brand_Value(cube, day, i)) {
+                            printf("%s ",cube->brandNames[i]);
                         } else {
                             counter++;
                         }
@@ -96,17 +361,22 @@ int main() {
                     //scan and check for a valid brand
                     do {
                         scanf("%d", &brandchoice);
-                        scanf("%d %d %d %d", &suvchoice, &sedanchoice, &coupechoice, &gtchoice);
-                        if (brandchoice < 0 || brandchoice > 4) {
+                        for (int i = 0; i < cube->types; i++) {
+                            scanf("%d", &typeschoice[i]);
+                        }
+                        if (brandchoice < 0 || brandchoice >= cube->brands) {
                             printf("This brand is not valid\n");
                         }
-                    } while ((brandchoice<0 || brandchoice>4) && !If_Brand_Value(day,brandchoice,cube,NUM_OF_TYPES));
+                    } while (brandchoice < 0 || brandchoice >= cube->brands);
 
                     //set the data for the current day
-                    Insert_Type_For_Brand(day, brandchoice, suvchoice, sedanchoice, coupechoice, gtchoice, cube);
+                    Insert_Type_For_Brand(cube, day, brandchoice, typeschoice);
 
                 }
                 day++;
+                if (cube->snapshot != NULL) {
+                    cube->snapshot->filledDays = day;
+                }
                 break;
             }
             case stats:
@@ -127,31 +397,31 @@ int main() {
                 printf("In day number %d:\n", daychoice+1);
 
                 //sales summary
-                for (int i = 0; i < NUM_OF_BRANDS; i++) {
-                    sum += Brand_Sum_Sales(daychoice, i, cube, NUM_OF_TYPES);
+                for (int i = 0; i < cube->brands; i++) {
+                    sum += Brand_Sum_Sales(cube, daychoice, i);
                 }
                 printf("The sales total was %d\n", sum);
 
                 //best sales brand
-                brandchoice = Best_Brand_Sales(daychoice, cube, NUM_OF_BRANDS, NUM_OF_TYPES);
+                brandchoice = Best_Brand_Sales(cube, daychoice);
 
                 //condition if there is no company with best sales
                 if (brandchoice == -1) {
                     printf("There is no brand with the best sales for this day\n");
                 } else {
                     printf("The best sold brand with %d sales was %s\n"
-                        , Brand_Sum_Sales(daychoice, brandchoice, cube, NUM_OF_TYPES), brands[brandchoice]);
+                        , Brand_Sum_Sales(cube, daychoice, brandchoice), cube->brandNames[brandchoice]);
                 }
 
                 //best types sales
-                brandchoice = Best_Type_Sales(daychoice, cube, NUM_OF_BRANDS, NUM_OF_TYPES);
+                brandchoice = Best_Type_Sales(cube, daychoice);
                 //I am using the brandchoice 2 times because there is no point in assigning another variable
                 //condition if there is no type with best sales
                 if (brandchoice == -1) {
                     printf("There is no type with the best sales for this day\n");
                 } else {
                     printf("The best sold type with %d sales was %s\n",
-                        Type_Sum_Sales(daychoice, brandchoice, cube, NUM_OF_BRANDS), types[brandchoice]);
+                        Type_Sum_Sales(cube, daychoice, brandchoice), cube->typeNames[brandchoice]);
                 }
                 break;
             }
@@ -160,12 +430,15 @@ int main() {
                 daychoice = 0;
                 printf("*****************************************\n\n");
 
-                for (int i = 0; i < NUM_OF_BRANDS; i++) {
-                    printf("Sales for %s:\n", brands[i]);
-                    for (int j = 0; j < DAYS_IN_YEAR; j++) {
-                        if (If_Brand_Value(j, i, cube, NUM_OF_TYPES)) {
-                            printf("Day %d- SUV: %d Sedan: %d Coupe: %d GT: %d\n",
-                                (1+j), cube[j][i][0], cube[j][i][1], cube[j][i][2], cube[j][i][3]);
+                for (int i = 0; i < cube->brands; i++) {
+                    printf("Sales for %s:\n", cube->brandNames[i]);
+                    for (int j = 0; j < cube->days; j++) {
+                        if (If_Brand_Value(cube, j, i)) {
+                            printf("Day %d-", 1+j);
+                            for (int w = 0; w < cube->types; w++) {
+                                printf(" %s: %d", cube->typeNames[w], CUBE_CELL(cube, j, i, w));
+                            }
+                            printf("\n");
                         }
                     }
                 }
@@ -175,89 +448,120 @@ int main() {
             }
             case insights:
             {
-                //best selling brand overall
-                int bestbrand[NUM_OF_BRANDS] = {0, 0, 0, 0, 0};
-                int sumbestbrand = 0, bestbrandindex = -1;
-                //*****************************************
-                //add to the sum of each brand
-                for (int i = 0; i < day; i++) {
-                    for (int j = 0; j < NUM_OF_BRANDS; j++) {
-                        bestbrand[j] += Brand_Sum_Sales(i, j, cube, NUM_OF_TYPES);
-                    }
+                //the totals are kept by the cube, or found again by scanning it on scanThreads threads
+                RangeStats scan;
+                const long long* brandtotals = cube->brandTotals;
+                const long long* typetotals = cube->typeTotals;
+                if (scanThreads > 0) {
+                    Alloc_Range_Stats(&scan, cube->brands, cube->types);
+                    Parallel_Range_Stats(cube, 0, cube->days - 1, scanThreads, &scan);
+                    brandtotals = scan.brandTotals;
+                    typetotals = scan.typeTotals;
                 }
-
-                //check for the highest sales in each brand
-                for (int i = 0; i < NUM_OF_BRANDS; i++) {
-                    if(sumbestbrand < bestbrand[i]) {
-                        sumbestbrand = bestbrand[i];
-                        bestbrandindex = i;
-                    }
-                }
-
+                //best selling brand overall
+                int bestbrandindex = scanThreads > 0 ? Best_Of(brandtotals, cube->brands) : Best_Brand_Overall(cube);
                 //check if no brand has the best and print, the -1 is if there is no values in the cube
                 if(bestbrandindex == -1) {
                     printf("There is no brand with the best sales\n");
                 } else {
-                    printf("The best-selling brand overall is %s: %d$\n",
-                        brands[bestbrandindex],bestbrand[bestbrandindex]);
+                    printf("The best-selling brand overall is %s: %lld$\n",
+                        cube->brandNames[bestbrandindex],brandtotals[bestbrandindex]);
                 }
                 //*************************************
 
                 //Best selling type overall
-                int besttype[NUM_OF_TYPES] = {0, 0, 0, 0};
-                int sumbesttype = 0, besttypeindex = -1;
-
-                //*************************************
-                for (int i = 0; i < day; i++) {
-                    for (int j = 0; j < NUM_OF_TYPES; j++) {
-                        besttype[j] += Type_Sum_Sales(i, j, cube,NUM_OF_BRANDS);
-                    }
-                }
-
-                //check for the highest sales in each type
-                for (int i = 0; i < NUM_OF_TYPES; i++) {
-                    if(sumbesttype < besttype[i]) {
-                        sumbesttype = besttype[i];
-                        besttypeindex = i;
-                    }
-                }
-
+                int besttypeindex = scanThreads > 0 ? Best_Of(typetotals, cube->types) : Best_Type_Overall(cube);
                 //check if no type has the best and print, the -1 is if there is no values in the cube
                 if(besttypeindex == -1) {
                     printf("There is no car type with the best sales\n");
                 } else {
-                    printf("The best-selling type of car is %s: %d$\n",
-                        types[besttypeindex],besttype[besttypeindex]);
+                    printf("The best-selling type of car is %s: %lld$\n",
+                        cube->typeNames[besttypeindex],typetotals[besttypeindex]);
                 }
                 //**********************************
 
                 //The most profitable day
-                int bestdaysum = -1, bestdayindex = -1;
-                //**********************************
-                for (int i = 0; i < DAYS_IN_YEAR; i++) {
-                    if(bestdaysum < All_Brands_Day_Sum_Sales(i, cube, NUM_OF_BRANDS, NUM_OF_TYPES)) {
-                        bestdaysum = All_Brands_Day_Sum_Sales(i, cube, NUM_OF_BRANDS, NUM_OF_TYPES);
-                        bestdayindex = i;
-                    }
-                }
-
+                int bestdayindex = scanThreads > 0 ? scan.bestDay : Most_Profitable_Day(cube);
                 //check if there is no most profitable day and print
                 if(bestdayindex == -1) {
                     printf("there is no day that is the most profitable");
                 } else {
-                    printf("The most profitable day was day number %d: %d$\n", bestdayindex + 1, bestdaysum);
+                    printf("The most profitable day was day number %d: %lld$\n", bestdayindex + 1,
+                        scanThreads > 0 ? scan.bestDaySales : cube->daySales[bestdayindex]);
                 }
                 //*********************************
+                if (scanThreads > 0) {
+                    Free_Range_Stats(&scan);
+                }
                 break;
             }
             case deltas:
             {
-                for (int i = 0; i < NUM_OF_BRANDS; i++) {
-                    printf("Brand: %s, Average Delta: %f\n", brands[i], Delta_Average(i, day, cube, NUM_OF_TYPES));
+                //the scan gives the first and the last day of every brand, less than two days are left to Delta_Average
+                if (scanThreads > 0 && day > 1) {
+                    RangeStats scan;
+                    Alloc_Range_Stats(&scan, cube->brands, cube->types);
+                    Parallel_Range_Stats(cube, 0, day - 1, scanThreads, &scan);
+                    for (int i = 0; i < cube->brands; i++) {
+                        printf("Brand: %s, Average Delta: %f\n", cube->brandNames[i],
+                            (double)(scan.brandLast[i] - scan.brandFirst[i]) / (day - 1));
+                    }
+                    Free_Range_Stats(&scan);
+                    break;
+                }
+                for (int i = 0; i < cube->brands; i++) {
+                    printf("Brand: %s, Average Delta: %f\n", cube->brandNames[i], Delta_Average(cube, i, day));
                 }
 
                 break;
             }
+            case rangeStats:
+            {
+                int fromday, today;
+                //scan for a valid range of days
+                do {
+                    printf("What range of days would you like to analyze (from, to)? \n");
+                    scanf("%d %d", &fromday, &today);
+                    //because the user inputs days from 1 to 365
+                    fromday--;
+                    today--;
+                    if (fromday < 0 || today < fromday || today >= day) {
+                        printf("Please enter a valid range.\n");
+                    }
+                } while (fromday < 0 || today < fromday || today >= day);
+
+                int rangedays = today - fromday + 1;
+                printf("In days %d to %d:\n", fromday+1, today+1);
+                if (scanThreads > 0) {
+                    RangeStats scan;
+                    Alloc_Range_Stats(&scan, cube->brands, cube->types);
+                    Parallel_Range_Stats(cube, fromday, today, scanThreads, &scan);
+                    printf("The sales total was %lld\n", scan.total);
+                    for (int i = 0; i < cube->brands; i++) {
+                        printf("Brand: %s, Total: %lld, Average: %f, Average Delta: %f\n", cube->brandNames[i],
+                            scan.brandTotals[i], (double)scan.brandTotals[i] / rangedays,
+                            rangedays == 1 ? 0 : (double)(scan.brandLast[i] - scan.brandFirst[i]) / (rangedays - 1));
+                    }
+                    for (int i = 0; i < cube->types; i++) {
+                        printf("Type: %s, Total: %lld, Average: %f\n", cube->typeNames[i], scan.typeTotals[i],
+                            (double)scan.typeTotals[i] / rangedays);
+                    }
+                    Free_Range_Stats(&scan);
+                    break;
+                }
+                printf("The sales total was %lld\n", Range_Sales(cube, fromday, today));
+                for (int i = 0; i < cube->brands; i++) {
+                    long long rangesum = Brand_Range_Sales(cube, i, fromday, today);
+                    printf("Brand: %s, Total: %lld, Average: %f, Average Delta: %f\n", cube->brandNames[i], rangesum,
+                        (double)rangesum / rangedays, Brand_Range_Delta(cube, i, fromday, today));
+                }
+                for (int i = 0; i < cube->types; i++) {
+                    long long rangesum = Type_Range_Sales(cube, i, fromday, today);
+                    printf("Type: %s, Total: %lld, Average: %f\n", cube->typeNames[i], rangesum,
+                        (double)rangesum / rangedays);
+                }
+                break;
+            }
             default:
                 printf("Invalid input\n");
         }
@@ -266,9 +570,16 @@ int main() {
     }
 
     printf("Goodbye!\n");
+    free(typeschoice);
+    if (cube->snapshot != NULL) {
+        Close_Snapshot(cube, day);
+    }
+    Free_Cube(cube);
     return 0;
 }
 
+//the options of the original menu keep their numbers so the inputs written for it still work,
+//a new option gets the next number and is printed after exit
 void printMenu(){
     printf("Welcome to the Cars Data Cube! What would you like to do?\n"
            "1.Enter Daily Data For A Brand\n"
@@ -277,42 +588,202 @@ void printMenu(){
            "4.Print All Data\n"
            "5.Provide Overall (simple) Insights\n"
            "6.Provide Average Delta Metrics\n"
-           "7.exit\n");
+           "7.exit\n"
+           "8.Provide Range Stats\n");
 }
 
-//checks a brand if at least one value is -1 that means its empty
-int If_Brand_Value(int day, int brand,int cube[][NUM_OF_BRANDS][NUM_OF_TYPES],int TYPES_SIZE) {
-    for (int i = 0; i < TYPES_SIZE; i++) {
-        if(cube[day][brand][i] == -1) {
-            return 0;
+//the first brands and types get their names from the lists above, the rest are numbered
+SalesCube* Create_Cube(int days, int brandsCount, int typesCount) {
+    SalesCube* cube = (SalesCube*)malloc(sizeof(SalesCube));
+    if (cube == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    cube->days = days;
+    cube->brands = brandsCount;
+    cube->types = typesCount;
+    cube->bestDay = -1;
+    cube->snapshot = NULL;
+    cube->snapshotSize = 0;
+    cube->snapshotFd = -1;
+    cube->snapshotPath = NULL;
+    cube->block = (char*)calloc(Cube_Layout(cube, NULL), 1);
+    if (cube->block == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    Cube_Layout(cube, cube->block);
+    for (int i = 0; i < brandsCount; i++) {
+        if (i < NUM_OF_BRANDS) {
+            strcpy(cube->brandNames[i], brands[i]);
+        } else {
+            sprintf(cube->brandNames[i], "Brand%d", i);
         }
-     }
-    return 1;
+    }
+    for (int i = 0; i < typesCount; i++) {
+        if (i < NUM_OF_TYPES) {
+            strcpy(cube->typeNames[i], types[i]);
+        } else {
+            sprintf(cube->typeNames[i], "Type%d", i);
+        }
+    }
+    return cube;
+}
+
+//places the arrays of the cube one after the other from the start of the block and returns the block's size,
+//with a NULL block only the size is calculated
+size_t Cube_Layout(SalesCube* cube, char* block) {
+    size_t offset = 0;
+    size_t days = (size_t)cube->days;
+    cube->presentWords = (cube->brands + BITS_IN_WORD - 1) / BITS_IN_WORD;
+    cube->sales = (int*)Layout_Part(block, &offset, (size_t)cube->brands * cube->types * days * sizeof(int));
+    cube->present = (unsigned long long*)Layout_Part(block, &offset,
+        days * cube->presentWords * sizeof(unsigned long long));
+    cube->brandNames = (char (*)[BRANDS_NAMES])Layout_Part(block, &offset, (size_t)cube->brands * BRANDS_NAMES);
+    cube->typeNames = (char (*)[TYPES_NAMES])Layout_Part(block, &offset, (size_t)cube->types * TYPES_NAMES);
+    cube->brandDaySales = (int*)Layout_Part(block, &offset, (size_t)cube->brands * days * sizeof(int));
+    cube->typeDaySales = (int*)Layout_Part(block, &offset, (size_t)cube->types * days * sizeof(int));
+    cube->daySales = (long long*)Layout_Part(block, &offset, days * sizeof(long long));
+    cube->brandTotals = (long long*)Layout_Part(block, &offset, (size_t)cube->brands * sizeof(long long));
+    cube->typeTotals = (long long*)Layout_Part(block, &offset, (size_t)cube->types * sizeof(long long));
+    cube->brandFenwick = (long long*)Layout_Part(block, &offset, (size_t)cube->brands * days * sizeof(long long));
+    cube->typeFenwick = (long long*)Layout_Part(block, &offset, (size_t)cube->types * days * sizeof(long long));
+    cube->dayFenwick = (long long*)Layout_Part(block, &offset, days * sizeof(long long));
+    return offset;
 }
 
-void Insert_Type_For_Brand(int day, int brandchoice, int suvchoice, int sedanchoice, int coupechoice, int gtchoice,
-    int cube[][NUM_OF_BRANDS][NUM_OF_TYPES]) {
-        cube [day][brandchoice][0] = suvchoice;
-        cube [day][brandchoice][1] = sedanchoice;
-        cube [day][brandchoice][2] = coupechoice;
-        cube [day][brandchoice][3] = gtchoice;
+//returns where a part of the given size starts in the block and moves the offset to the part after it
+void* Layout_Part(char* block, size_t* offset, size_t size) {
+    void* part = block == NULL ? NULL : block + *offset;
+    *offset += (size + CUBE_ALIGN - 1) / CUBE_ALIGN * CUBE_ALIGN;
+    return part;
 }
 
-int Brand_Sum_Sales(int day, int brandchoice, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int TYPES_SIZE) {
-    int sum = 0;
-    for (int i = 0; i < TYPES_SIZE; i++) {
-        if (cube[day][brandchoice][i] != -1) {
-            sum += cube[day][brandchoice][i];
+//copies columns of fromDays cells into columns of toDays cells
+void Copy_Columns(void* to, const void* from, size_t columns, int toDays, int fromDays, size_t cellSize) {
+    for (size_t column = 0; column < columns; column++) {
+        memcpy((char*)to + column * toDays * cellSize, (const char*)from + column * fromDays * cellSize,
+            (size_t)fromDays * cellSize);
+    }
+}
+
+//makes room for more days, every column is copied to its new place and the new days are empty
+void Grow_Cube(SalesCube* cube, int days) {
+    SalesCube grown = *cube;
+    grown.days = days;
+    size_t blockSize = Cube_Layout(&grown, NULL);
+    grown.block = (char*)calloc(blockSize, 1);
+    if (grown.block == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    Cube_Layout(&grown, grown.block);
+    Copy_Columns(grown.sales, cube->sales, (size_t)cube->brands * cube->types, days, cube->days, sizeof(int));
+    Copy_Columns(grown.brandDaySales, cube->brandDaySales, (size_t)cube->brands, days, cube->days, sizeof(int));
+    Copy_Columns(grown.typeDaySales, cube->typeDaySales, (size_t)cube->types, days, cube->days, sizeof(int));
+    Copy_Columns(grown.daySales, cube->daySales, 1, days, cube->days, sizeof(long long));
+    memcpy(grown.present, cube->present, (size_t)cube->days * cube->presentWords * sizeof(unsigned long long));
+    memcpy(grown.brandNames, cube->brandNames, (size_t)cube->brands * BRANDS_NAMES);
+    memcpy(grown.typeNames, cube->typeNames, (size_t)cube->types * TYPES_NAMES);
+    memcpy(grown.brandTotals, cube->brandTotals, (size_t)cube->brands * sizeof(long long));
+    memcpy(grown.typeTotals, cube->typeTotals, (size_t)cube->types * sizeof(long long));
+    //a tree that covers more days has other ranges, so the trees are built again from the daily sales
+    for (int i = 0; i < grown.brands; i++) {
+        for (int j = 0; j < days; j++) {
+            grown.brandFenwick[(size_t)i * days + j] = grown.brandDaySales[(size_t)i * days + j];
         }
+        Fenwick_Build(grown.brandFenwick + (size_t)i * days, days);
     }
-    return sum;
+    for (int i = 0; i < grown.types; i++) {
+        for (int j = 0; j < days; j++) {
+            grown.typeFenwick[(size_t)i * days + j] = grown.typeDaySales[(size_t)i * days + j];
+        }
+        Fenwick_Build(grown.typeFenwick + (size_t)i * days, days);
+    }
+    memcpy(grown.dayFenwick, grown.daySales, (size_t)days * sizeof(long long));
+    Fenwick_Build(grown.dayFenwick, days);
+    if (cube->snapshot == NULL) {
+        free(cube->block);
+        *cube = grown;
+        return;
+    }
+    //every column moves when the days grow, so a snapshot is written again as a new file next to the old one
+    //and only replaces it once it is all on the disk - a crash in between leaves the old snapshot whole.
+    //the capacity doubles every time so this happens only a few times
+    char* heapBlock = grown.block;
+    SnapshotHeader header = *cube->snapshot;
+    if (!Replace_Snapshot(&grown, &header, heapBlock, blockSize)) {
+        printf("Cannot grow the snapshot\n");
+        exit(1);
+    }
+    free(heapBlock);
+    munmap(cube->snapshot, cube->snapshotSize);
+    close(cube->snapshotFd);
+    *cube = grown;
 }
 
-int Best_Brand_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE, int TYPES_SIZE) {
+void Free_Cube(SalesCube* cube) {
+    if (cube->snapshot != NULL) {
+        munmap(cube->snapshot, cube->snapshotSize);
+        close(cube->snapshotFd);
+        free(cube->snapshotPath);
+    } else {
+        free(cube->block);
+    }
+    free(cube);
+}
+
+//checks if a brand has data for the day
+int If_Brand_Value(const SalesCube* cube, int day, int brand) {
+    return (cube->present[(size_t)day * cube->presentWords + brand / BITS_IN_WORD] >> (brand % BITS_IN_WORD)) & 1;
+}
+
+//checks if any brand has data for the day
+int If_Day_Value(const SalesCube* cube, int day) {
+    for (int i = 0; i < cube->presentWords; i++) {
+        if (cube->present[(size_t)day * cube->presentWords + i] != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//sales[] has a number for every type, the totals change by the difference from what the brand had before
+void Insert_Type_For_Brand(SalesCube* cube, int day, int brandchoice, const int sales[]) {
+    int brandDelta = 0;
+    for (int i = 0; i < cube->types; i++) {
+        int delta = sales[i] - CUBE_CELL(cube, day, brandchoice, i);
+        CUBE_CELL(cube, day, brandchoice, i) = sales[i];
+        cube->typeDaySales[(size_t)i * cube->days + day] += delta;
+        cube->typeTotals[i] += delta;
+        Fenwick_Add(cube->typeFenwick + (size_t)i * cube->days, cube->days, day, delta);
+        brandDelta += delta;
+    }
+    cube->brandDaySales[(size_t)brandchoice * cube->days + day] += brandDelta;
+    cube->brandTotals[brandchoice] += brandDelta;
+    cube->daySales[day] += brandDelta;
+    Fenwick_Add(cube->brandFenwick + (size_t)brandchoice * cube->days, cube->days, day, brandDelta);
+    Fenwick_Add(cube->dayFenwick, cube->days, day, brandDelta);
+    cube->present[(size_t)day * cube->presentWords + brandchoice / BITS_IN_WORD] |= 1ULL << (brandchoice % BITS_IN_WORD);
+
+    //a day that went up can only take the best day's place, a best day that went down has to be searched again
+    if (cube->bestDay >= 0 && day == cube->bestDay && brandDelta < 0) {
+        cube->bestDay = -2;
+    } else if (cube->bestDay == -1 || (cube->bestDay >= 0 && (cube->daySales[day] > cube->daySales[cube->bestDay]
+        || (cube->daySales[day] == cube->daySales[cube->bestDay] && day < cube->bestDay)))) {
+        cube->bestDay = day;
+    }
+}
+
+int Brand_Sum_Sales(const SalesCube* cube, int day, int brandchoice) {
+    return cube->brandDaySales[(size_t)brandchoice * cube->days + day];
+}
+
+int Best_Brand_Sales(const SalesCube* cube, int day) {
     int bestsum = -1, bestbrand = -1, sumtemp;
 
-    for (int i = 0; i < BRANDS_SIZE; i++) {
-        sumtemp = Brand_Sum_Sales(day, i, cube, TYPES_SIZE);
+    for (int i = 0; i < cube->brands; i++) {
+        sumtemp = Brand_Sum_Sales(cube, day, i);
         if (bestsum < sumtemp) {
             bestsum = sumtemp;
             bestbrand = i;
@@ -322,19 +793,15 @@ int Best_Brand_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRAND
     return bestbrand;
 }
 
-int Type_Sum_Sales(int day, int type, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE) {
-    int sum = 0;
-    for (int i = 0; i < BRANDS_SIZE; i++) {
-        sum += cube[day][i][type];
-    }
-    return sum;
+int Type_Sum_Sales(const SalesCube* cube, int day, int type) {
+    return cube->typeDaySales[(size_t)type * cube->days + day];
 }
 
-int Best_Type_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE, int TYPES_SIZE) {
+int Best_Type_Sales(const SalesCube* cube, int day) {
     int bestsum = -1, besttype = -1, sumtemp;
 
-    for (int i = 0; i < TYPES_SIZE; i++) {
-        sumtemp = Type_Sum_Sales(day, i, cube, BRANDS_SIZE);
+    for (int i = 0; i < cube->types; i++) {
+        sumtemp = Type_Sum_Sales(cube, day, i);
         if (bestsum < sumtemp) {
             bestsum = sumtemp;
             besttype = i;
@@ -344,21 +811,904 @@ int Best_Type_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS
     return besttype;
 }
 
-int All_Brands_Day_Sum_Sales(int day, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int BRANDS_SIZE, int TYPES_SIZE) {
-    int sum = 0;
-    for (int i = 0; i < BRANDS_SIZE; i++) {
-        for (int j = 0; j < TYPES_SIZE; j++) {
-            sum += cube[day][i][j];
+//the brand with the most sales of all the days, -1 if no brand sold anything
+int Best_Brand_Overall(const SalesCube* cube) {
+    long long bestsum = 0;
+    int bestbrand = -1;
+    for (int i = 0; i < cube->brands; i++) {
+        if (bestsum < cube->brandTotals[i]) {
+            bestsum = cube->brandTotals[i];
+            bestbrand = i;
         }
     }
-    return sum;
+    return bestbrand;
+}
+
+//the type with the most sales of all the days, -1 if no type sold anything
+int Best_Type_Overall(const SalesCube* cube) {
+    long long bestsum = 0;
+    int besttype = -1;
+    for (int i = 0; i < cube->types; i++) {
+        if (bestsum < cube->typeTotals[i]) {
+            bestsum = cube->typeTotals[i];
+            besttype = i;
+        }
+    }
+    return besttype;
+}
+
+//the first day with the most sales out of the days with data, -1 if there is no data.
+//the answer is kept between calls and is only searched again after the best day lost sales
+int Most_Profitable_Day(SalesCube* cube) {
+    if (cube->bestDay != -2) {
+        return cube->bestDay;
+    }
+    cube->bestDay = -1;
+    for (int i = 0; i < cube->days; i++) {
+        if (If_Day_Value(cube, i) && (cube->bestDay == -1 || cube->daySales[cube->bestDay] < cube->daySales[i])) {
+            cube->bestDay = i;
+        }
+    }
+    return cube->bestDay;
 }
 
-double Delta_Average(int brand,int currentday, int cube[][NUM_OF_BRANDS][NUM_OF_TYPES], int TYPES_SIZE) {
-    double sum = 0, difference;
-    for (int i = 1; i < currentday; i++) {
-        difference = Brand_Sum_Sales(i, brand, cube, TYPES_SIZE)-Brand_Sum_Sales(i-1, brand, cube, TYPES_SIZE);
-        sum += difference;
+//the differences between following days add up to the last day minus the first one
+double Delta_Average(const SalesCube* cube, int brand, int currentday) {
+    double sum = 0;
+    if (currentday > 1) {
+        sum = Brand_Sum_Sales(cube, currentday-1, brand) - Brand_Sum_Sales(cube, 0, brand);
     }
     return sum/(currentday-1);
 }
+
+//a 0 based Fenwick tree - tree[i] holds the sum of the days from (i & (i+1)) to i
+void Fenwick_Add(long long tree[], int size, int day, long long delta) {
+    for (int i = day; i < size; i |= i + 1) {
+        tree[i] += delta;
+    }
+}
+
+//the sales of the days from 0 to day (0 for day -1)
+long long Fenwick_Prefix(const long long tree[], int day) {
+    long long sum = 0;
+    for (int i = day; i >= 0; i = (i & (i + 1)) - 1) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+//turns the sales of every day in tree[] into a Fenwick tree, each day is added to the one node above it
+void Fenwick_Build(long long tree[], int size) {
+    for (int i = 0; i < size; i++) {
+        int parent = i | (i + 1);
+        if (parent < size) {
+            tree[parent] += tree[i];
+        }
+    }
+}
+
+long long Brand_Range_Sales(const SalesCube* cube, int brand, int from, int to) {
+    const long long* tree = cube->brandFenwick + (size_t)brand * cube->days;
+    return Fenwick_Prefix(tree, to) - Fenwick_Prefix(tree, from - 1);
+}
+
+long long Type_Range_Sales(const SalesCube* cube, int type, int from, int to) {
+    const long long* tree = cube->typeFenwick + (size_t)type * cube->days;
+    return Fenwick_Prefix(tree, to) - Fenwick_Prefix(tree, from - 1);
+}
+
+long long Range_Sales(const SalesCube* cube, int from, int to) {
+    return Fenwick_Prefix(cube->dayFenwick, to) - Fenwick_Prefix(cube->dayFenwick, from - 1);
+}
+
+//the average change from day to day inside the range, 0 for a range of one day
+double Brand_Range_Delta(const SalesCube* cube, int brand, int from, int to) {
+    if (to == from) {
+        return 0;
+    }
+    return (double)(Brand_Sum_Sales(cube, to, brand) - Brand_Sum_Sales(cube, from, brand)) / (to - from);
+}
+
+//sse2 is in every x86-64 cpu, avx2 has to be asked for
+void Select_Kernels() {
+    scalarKernels.name = "scalar";
+    scalarKernels.sumColumn = Sum_Column_Scalar;
+    scalarKernels.addColumn = Add_Column_Scalar;
+    kernels = scalarKernels;
+#ifdef CUBE_SIMD
+    sse2Kernels.name = "sse2";
+    sse2Kernels.sumColumn = Sum_Column_Sse2;
+    sse2Kernels.addColumn = Add_Column_Sse2;
+    avx2Kernels.name = "avx2";
+    avx2Kernels.sumColumn = Sum_Column_Avx2;
+    avx2Kernels.addColumn = Add_Column_Avx2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels = sse2Kernels;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels = avx2Kernels;
+    }
+#endif
+}
+
+long long Sum_Column_Scalar(const int* column, int count) {
+    long long sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += column[i];
+    }
+    return sum;
+}
+
+void Add_Column_Scalar(long long* totals, const int* column, int count) {
+    for (int i = 0; i < count; i++) {
+        totals[i] += column[i];
+    }
+}
+
+#ifdef CUBE_SIMD
+//the sales are added as 64 bit numbers so a long column can not overflow,
+//sse2 has no sign extension so the high half of every number is made from its sign
+__attribute__((target("sse2")))
+long long Sum_Column_Sse2(const int* column, int count) {
+    __m128i sum0 = _mm_setzero_si128(), sum1 = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(column + i));
+        __m128i signs = _mm_srai_epi32(values, 31);
+        sum0 = _mm_add_epi64(sum0, _mm_unpacklo_epi32(values, signs));
+        sum1 = _mm_add_epi64(sum1, _mm_unpackhi_epi32(values, signs));
+    }
+    long long lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, _mm_add_epi64(sum0, sum1));
+    long long sum = lanes[0] + lanes[1];
+    for (; i < count; i++) {
+        sum += column[i];
+    }
+    return sum;
+}
+
+__attribute__((target("sse2")))
+void Add_Column_Sse2(long long* totals, const int* column, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(column + i));
+        __m128i signs = _mm_srai_epi32(values, 31);
+        __m128i* to = (__m128i*)(totals + i);
+        _mm_storeu_si128(to, _mm_add_epi64(_mm_loadu_si128(to), _mm_unpacklo_epi32(values, signs)));
+        _mm_storeu_si128(to + 1, _mm_add_epi64(_mm_loadu_si128(to + 1), _mm_unpackhi_epi32(values, signs)));
+    }
+    for (; i < count; i++) {
+        totals[i] += column[i];
+    }
+}
+
+__attribute__((target("avx2")))
+long long Sum_Column_Avx2(const int* column, int count) {
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_epi64(sum0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(column + i))));
+        sum1 = _mm256_add_epi64(sum1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(column + i + 4))));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(sum0, sum1));
+    long long sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; i++) {
+        sum += column[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2")))
+void Add_Column_Avx2(long long* totals, const int* column, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i values = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(column + i)));
+        __m256i* to = (__m256i*)(totals + i);
+        _mm256_storeu_si256(to, _mm256_add_epi64(_mm256_loadu_si256(to), values));
+    }
+    for (; i < count; i++) {
+        totals[i] += column[i];
+    }
+}
+#endif
+
+//totals[day - from] - the sales of all the brands in every day from "from" to "to"
+void Scan_Day_Totals(const SalesCube* cube, const CubeKernels* use, int from, int to, long long totals[]) {
+    memset(totals, 0, (size_t)(to - from + 1) * sizeof(long long));
+    for (size_t column = 0; column < (size_t)cube->brands * cube->types; column++) {
+        use->addColumn(totals, cube->sales + column * cube->days + from, to - from + 1);
+    }
+}
+
+//totals[brand] - the sales of every brand in the days from "from" to "to"
+void Scan_Brand_Totals(const SalesCube* cube, const CubeKernels* use, int from, int to, long long totals[]) {
+    for (int i = 0; i < cube->brands; i++) {
+        totals[i] = 0;
+        for (int j = 0; j < cube->types; j++) {
+            totals[i] += use->sumColumn(&CUBE_CELL(cube, from, i, j), to - from + 1);
+        }
+    }
+}
+
+//totals[type] - the sales of every type in the days from "from" to "to"
+void Scan_Type_Totals(const SalesCube* cube, const CubeKernels* use, int from, int to, long long totals[]) {
+    memset(totals, 0, (size_t)cube->types * sizeof(long long));
+    for (int i = 0; i < cube->brands; i++) {
+        for (int j = 0; j < cube->types; j++) {
+            totals[j] += use->sumColumn(&CUBE_CELL(cube, from, i, j), to - from + 1);
+        }
+    }
+}
+
+int Scan_Best_Brand(const SalesCube* cube, const CubeKernels* use, int from, int to) {
+    long long* totals = (long long*)malloc((size_t)cube->brands * sizeof(long long));
+    if (totals == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    Scan_Brand_Totals(cube, use, from, to, totals);
+    int best = Best_Of(totals, cube->brands);
+    free(totals);
+    return best;
+}
+
+int Scan_Best_Type(const SalesCube* cube, const CubeKernels* use, int from, int to) {
+    long long* totals = (long long*)malloc((size_t)cube->types * sizeof(long long));
+    if (totals == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    Scan_Type_Totals(cube, use, from, to, totals);
+    int best = Best_Of(totals, cube->types);
+    free(totals);
+    return best;
+}
+
+//the first index with the biggest positive total, -1 if none of them sold anything
+int Best_Of(const long long totals[], int count) {
+    long long bestsum = 0;
+    int best = -1;
+    for (int i = 0; i < count; i++) {
+        if (bestsum < totals[i]) {
+            bestsum = totals[i];
+            best = i;
+        }
+    }
+    return best;
+}
+
+double Seconds_Now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+//fills a cube with random sales and times every set of kernels against the cell by cell loops
+//the stats used before the columns (a day at a time, every brand and type of the day)
+int Run_Bench(int days, int brandsCount, int typesCount) {
+    if (days < 1 || brandsCount < 1 || typesCount < 1) {
+        printf("The cube needs at least one day, brand and type\n");
+        return 1;
+    }
+    SalesCube* cube = Create_Cube(days, brandsCount, typesCount);
+    long long* dayTotals = (long long*)malloc((size_t)days * sizeof(long long));
+    long long* brandTotals = (long long*)malloc((size_t)brandsCount * sizeof(long long));
+    if (dayTotals == NULL || brandTotals == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    srand(1);
+    for (size_t i = 0; i < (size_t)days * brandsCount * typesCount; i++) {
+        cube->sales[i] = rand() % 100;
+    }
+    double megabytes = (double)days * brandsCount * typesCount * sizeof(int) / 1e6;
+    printf("Cube of %d days, %d brands and %d types (%.1f MB), best of %d rounds:\n",
+        days, brandsCount, typesCount, megabytes, BENCH_ROUNDS);
+    printf("%-12s %14s %14s %14s %14s\n", "kernel", "day totals", "brand totals", "best brand", "best type");
+
+    //the cell by cell loops
+    long long check = 0;
+    double best[4] = {1e9, 1e9, 1e9, 1e9};
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double start = Seconds_Now();
+        for (int d = 0; d < days; d++) {
+            long long sum = 0;
+            for (int i = 0; i < brandsCount; i++) {
+                for (int j = 0; j < typesCount; j++) {
+                    sum += CUBE_CELL(cube, d, i, j);
+                }
+            }
+            dayTotals[d] = sum;
+        }
+        double split = Seconds_Now();
+        for (int i = 0; i < brandsCount; i++) {
+            brandTotals[i] = 0;
+            for (int d = 0; d < days; d++) {
+                for (int j = 0; j < typesCount; j++) {
+                    brandTotals[i] += CUBE_CELL(cube, d, i, j);
+                }
+            }
+        }
+        double end = Seconds_Now();
+        best[0] = split - start < best[0] ? split - start : best[0];
+        best[1] = end - split < best[1] ? end - split : best[1];
+    }
+    for (int d = 0; d < days; d++) {
+        check += dayTotals[d];
+    }
+    printf("%-12s %11.2f ms %11.2f ms %14s %14s\n", "cell loops", best[0] * 1e3, best[1] * 1e3, "-", "-");
+
+    CubeKernels all[3];
+    int kernelsCount = 0;
+    all[kernelsCount++] = scalarKernels;
+#ifdef CUBE_SIMD
+    if (__builtin_cpu_supports("sse2")) {
+        all[kernelsCount++] = sse2Kernels;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        all[kernelsCount++] = avx2Kernels;
+    }
+#endif
+    int bestBrand = -1, bestType = -1;
+    for (int k = 0; k < kernelsCount; k++) {
+        best[0] = best[1] = best[2] = best[3] = 1e9;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            double start = Seconds_Now();
+            Scan_Day_Totals(cube, &all[k], 0, days - 1, dayTotals);
+            double split = Seconds_Now();
+            Scan_Brand_Totals(cube, &all[k], 0, days - 1, brandTotals);
+            double split2 = Seconds_Now();
+            bestBrand = Scan_Best_Brand(cube, &all[k], 0, days - 1);
+            double split3 = Seconds_Now();
+            bestType = Scan_Best_Type(cube, &all[k], 0, days - 1);
+            double end = Seconds_Now();
+            best[0] = split - start < best[0] ? split - start : best[0];
+            best[1] = split2 - split < best[1] ? split2 - split : best[1];
+            best[2] = split3 - split2 < best[2] ? split3 - split2 : best[2];
+            best[3] = end - split3 < best[3] ? end - split3 : best[3];
+        }
+        long long sum = 0, brandSum = 0;
+        for (int d = 0; d < days; d++) {
+            sum += dayTotals[d];
+        }
+        for (int i = 0; i < brandsCount; i++) {
+            brandSum += brandTotals[i];
+        }
+        printf("%-12s %11.2f ms %11.2f ms %11.2f ms %11.2f ms  %.1f GB/s%s%s\n", all[k].name, best[0] * 1e3,
+            best[1] * 1e3, best[2] * 1e3, best[3] * 1e3, megabytes / 1e3 / best[1],
+            kernels.name == all[k].name ? " (selected)" : "",
+            sum != check || brandSum != check ? " - WRONG TOTALS" : "");
+    }
+    printf("The best-selling brand is %s\n", bestBrand == -1 ? "none" : cube->brandNames[bestBrand]);
+    printf("The best-selling type is %s\n", bestType == -1 ? "none" : cube->typeNames[bestType]);
+    free(dayTotals);
+    free(brandTotals);
+    Free_Cube(cube);
+    return 0;
+}
+
+void Alloc_Range_Stats(RangeStats* result, int brandsCount, int typesCount) {
+    result->brandTotals = (long long*)malloc((size_t)brandsCount * 3 * sizeof(long long));
+    result->typeTotals = (long long*)malloc((size_t)typesCount * sizeof(long long));
+    if (result->brandTotals == NULL || result->typeTotals == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    result->brandFirst = result->brandTotals + brandsCount;
+    result->brandLast = result->brandFirst + brandsCount;
+}
+
+void Free_Range_Stats(RangeStats* result) {
+    free(result->brandTotals);
+    free(result->typeTotals);
+}
+
+//the work of one thread - every column of the cube is read once over the chunk's days for the brand and
+//type totals and once more for the day totals, then the best day is picked out of the days with data
+void* Scan_Range_Chunk(void* arg) {
+    RangeChunk* chunk = (RangeChunk*)arg;
+    const SalesCube* cube = chunk->cube;
+    RangeStats* result = &chunk->partial;
+    int count = chunk->to - chunk->from + 1;
+    memset(result->typeTotals, 0, (size_t)cube->types * sizeof(long long));
+    memset(chunk->dayTotals, 0, (size_t)count * sizeof(long long));
+    result->total = 0;
+    for (int i = 0; i < cube->brands; i++) {
+        result->brandTotals[i] = result->brandFirst[i] = result->brandLast[i] = 0;
+        for (int j = 0; j < cube->types; j++) {
+            const int* column = &CUBE_CELL(cube, chunk->from, i, j);
+            long long sum = chunk->use->sumColumn(column, count);
+            chunk->use->addColumn(chunk->dayTotals, column, count);
+            result->brandTotals[i] += sum;
+            result->typeTotals[j] += sum;
+            result->brandFirst[i] += column[0];
+            result->brandLast[i] += column[count - 1];
+        }
+        result->total += result->brandTotals[i];
+    }
+    result->bestDay = -1;
+    result->bestDaySales = 0;
+    for (int d = 0; d < count; d++) {
+        if (If_Day_Value(cube, chunk->from + d)
+            && (result->bestDay == -1 || result->bestDaySales < chunk->dayTotals[d])) {
+            result->bestDay = chunk->from + d;
+            result->bestDaySales = chunk->dayTotals[d];
+        }
+    }
+    return NULL;
+}
+
+//the sums of the days from "from" to "to", found by splitting the days between threads.
+//every thread scans its own chunk of every column into its own partial sums, and the partials are added up
+//in the order of the chunks so the first best day wins like in Most_Profitable_Day
+void Parallel_Range_Stats(const SalesCube* cube, int from, int to, int threads, RangeStats* result) {
+    int days = to - from + 1;
+    int chunks = threads < 1 ? 1 : threads > days ? days : threads;
+    RangeChunk* chunk = (RangeChunk*)malloc((size_t)chunks * sizeof(RangeChunk));
+    pthread_t* thread = (pthread_t*)malloc((size_t)chunks * sizeof(pthread_t));
+    int* started = (int*)calloc((size_t)chunks, sizeof(int));
+    long long* dayTotals = (long long*)malloc((size_t)days * sizeof(long long));
+    if (chunk == NULL || thread == NULL || started == NULL || dayTotals == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    for (int c = 0; c < chunks; c++) {
+        chunk[c].cube = cube;
+        chunk[c].use = &kernels;
+        chunk[c].from = from + (int)((long long)days * c / chunks);
+        chunk[c].to = from + (int)((long long)days * (c + 1) / chunks) - 1;
+        chunk[c].dayTotals = dayTotals + (chunk[c].from - from);
+        Alloc_Range_Stats(&chunk[c].partial, cube->brands, cube->types);
+    }
+    //the first chunk is scanned by this thread, a chunk without a thread is scanned here too
+    for (int c = 1; c < chunks; c++) {
+        started[c] = pthread_create(&thread[c], NULL, Scan_Range_Chunk, &chunk[c]) == 0;
+    }
+    Scan_Range_Chunk(&chunk[0]);
+    for (int c = 1; c < chunks; c++) {
+        if (started[c]) {
+            pthread_join(thread[c], NULL);
+        } else {
+            Scan_Range_Chunk(&chunk[c]);
+        }
+    }
+
+    memcpy(result->brandTotals, chunk[0].partial.brandTotals, (size_t)cube->brands * sizeof(long long));
+    memcpy(result->typeTotals, chunk[0].partial.typeTotals, (size_t)cube->types * sizeof(long long));
+    memcpy(result->brandFirst, chunk[0].partial.brandFirst, (size_t)cube->brands * sizeof(long long));
+    memcpy(result->brandLast, chunk[chunks - 1].partial.brandLast, (size_t)cube->brands * sizeof(long long));
+    result->total = chunk[0].partial.total;
+    result->bestDay = chunk[0].partial.bestDay;
+    result->bestDaySales = chunk[0].partial.bestDaySales;
+    for (int c = 1; c < chunks; c++) {
+        const RangeStats* part = &chunk[c].partial;
+        for (int i = 0; i < cube->brands; i++) {
+            result->brandTotals[i] += part->brandTotals[i];
+        }
+        for (int j = 0; j < cube->types; j++) {
+            result->typeTotals[j] += part->typeTotals[j];
+        }
+        result->total += part->total;
+        if (part->bestDay != -1 && (result->bestDay == -1 || result->bestDaySales < part->bestDaySales)) {
+            result->bestDay = part->bestDay;
+            result->bestDaySales = part->bestDaySales;
+        }
+    }
+    for (int c = 0; c < chunks; c++) {
+        Free_Range_Stats(&chunk[c].partial);
+    }
+    free(chunk);
+    free(thread);
+    free(started);
+    free(dayTotals);
+}
+
+int Online_Cores() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores < 1 ? 1 : cores > MAX_THREADS ? MAX_THREADS : (int)cores;
+}
+
+//fills a cube with random sales and times the parallel range scan over all of its days with 1, 2, 4...
+//threads up to maxThreads, every result is checked against the one of a single thread
+int Run_Scale_Bench(int days, int brandsCount, int typesCount, int maxThreads) {
+    if (days < 1 || brandsCount < 1 || typesCount < 1) {
+        printf("The cube needs at least one day, brand and type\n");
+        return 1;
+    }
+    maxThreads = maxThreads < 1 ? 1 : maxThreads > MAX_THREADS ? MAX_THREADS : maxThreads;
+    SalesCube* cube = Create_Cube(days, brandsCount, typesCount);
+    srand(1);
+    for (size_t i = 0; i < (size_t)days * brandsCount * typesCount; i++) {
+        cube->sales[i] = rand() % 100;
+    }
+    //every day has data for the best day search
+    memset(cube->present, 0xff, (size_t)days * cube->presentWords * sizeof(unsigned long long));
+    double megabytes = (double)days * brandsCount * typesCount * sizeof(int) / 1e6;
+    printf("Cube of %d days, %d brands and %d types (%.1f MB), %s kernels, %d cores, best of %d rounds:\n",
+        days, brandsCount, typesCount, megabytes, kernels.name, Online_Cores(), BENCH_ROUNDS);
+    printf("%-8s %12s %10s %8s\n", "threads", "range scan", "GB/s", "speedup");
+
+    RangeStats single, scan;
+    Alloc_Range_Stats(&single, brandsCount, typesCount);
+    Alloc_Range_Stats(&scan, brandsCount, typesCount);
+    double first = 0;
+    for (int threads = 1; threads <= maxThreads; threads = threads * 2 > maxThreads && threads < maxThreads ?
+        maxThreads : threads * 2) {
+        double best = 1e9;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            double start = Seconds_Now();
+            Parallel_Range_Stats(cube, 0, days - 1, threads, threads == 1 ? &single : &scan);
+            double end = Seconds_Now();
+            best = end - start < best ? end - start : best;
+        }
+        int wrong = 0;
+        if (threads == 1) {
+            first = best;
+        } else {
+            wrong = scan.total != single.total || scan.bestDay != single.bestDay
+                || memcmp(scan.brandTotals, single.brandTotals, (size_t)brandsCount * 3 * sizeof(long long)) != 0
+                || memcmp(scan.typeTotals, single.typeTotals, (size_t)typesCount * sizeof(long long)) != 0;
+        }
+        printf("%-8d %9.2f ms %10.1f %7.2fx%s\n", threads, best * 1e3, megabytes / 1e3 / best, first / best,
+            wrong ? " - WRONG TOTALS" : "");
+    }
+    printf("The most profitable day was day number %d: %lld$\n", single.bestDay + 1, single.bestDaySales);
+    Free_Range_Stats(&single);
+    Free_Range_Stats(&scan);
+    Free_Cube(cube);
+    return 0;
+}
+
+//reads a whole file of rows into the cube - every row sets one type of one brand on one day.
+//a csv file has a "day,brand,type,sales" row on every line (the day starts from 1 like in the menu,
+//lines that do not start with a number are skipped), a binary file starts with ROWS_MAGIC.
+//the file is mapped into memory (a pipe is read into the heap) and parsed in place, the daily sums and totals
+//are updated with every row and the Fenwick trees are built once at the end.
+//lastDay gets the number of days up to the last one that was loaded, returns 0 if the file can not be read
+int Load_Rows(SalesCube* cube, const char* path, int* lastDay) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Cannot open %s\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+    size_t size = (size_t)info.st_size;
+    const char* data = NULL;
+    //a pipe has no size and can not be mapped, it is read into the heap instead
+    char* readData = NULL;
+    if (!S_ISREG(info.st_mode)) {
+        size_t capacity = 0;
+        size = 0;
+        ssize_t got;
+        do {
+            if (size == capacity) {
+                capacity = capacity == 0 ? 1 << 16 : capacity * 2;
+                char* grown = (char*)realloc(readData, capacity);
+                if (grown == NULL) {
+                    printf("Memory allocation error\n");
+                    exit(1);
+                }
+                readData = grown;
+            }
+            got = read(fd, readData + size, capacity - size);
+            if (got > 0) {
+                size += (size_t)got;
+            }
+        } while (got > 0);
+        if (got < 0) {
+            printf("Cannot read %s\n", path);
+            free(readData);
+            close(fd);
+            return 0;
+        }
+        data = readData;
+    } else if (size > 0) {
+        data = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            printf("Cannot read %s\n", path);
+            close(fd);
+            return 0;
+        }
+        posix_madvise((void*)data, size, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    double start = Seconds_Now();
+    long long rows = 0, rejected = 0;
+    int last = -1;
+    if (size >= ROWS_MAGIC_SIZE && memcmp(data, ROWS_MAGIC, ROWS_MAGIC_SIZE) == 0) {
+        size_t count = (size - ROWS_MAGIC_SIZE) / (ROW_FIELDS * sizeof(int));
+        for (size_t i = 0; i < count; i++) {
+            int row[ROW_FIELDS];
+            memcpy(row, data + ROWS_MAGIC_SIZE + i * sizeof(row), sizeof(row));
+            if (row[0] > 0 && Load_Row(cube, row[0] - 1, row[1], row[2], row[3])) {
+                rows++;
+                last = row[0] - 1 > last ? row[0] - 1 : last;
+            } else {
+                rejected++;
+            }
+        }
+        //a cut row at the end
+        if ((size - ROWS_MAGIC_SIZE) % (ROW_FIELDS * sizeof(int)) != 0) {
+            rejected++;
+        }
+    } else {
+        const char* at = data;
+        const char* end = data + size;
+        while (at < end) {
+            const char* lineEnd = (const char*)memchr(at, '\n', (size_t)(end - at));
+            if (lineEnd == NULL) {
+                lineEnd = end;
+            }
+            const char* first = at;
+            while (first < lineEnd && (*first == ' ' || *first == '\t' || *first == '\r')) {
+                first++;
+            }
+            //empty lines and titles are not rows
+            if (first < lineEnd && (*first == '-' || (*first >= '0' && *first <= '9'))) {
+                int row[ROW_FIELDS];
+                const char* field = first;
+                int fields = 0;
+                while (fields < ROW_FIELDS && field != NULL) {
+                    field = Parse_Number(field, lineEnd, &row[fields]);
+                    if (field != NULL) {
+                        fields++;
+                        //the fields are separated by commas
+                        while (field < lineEnd && (*field == ' ' || *field == '\t')) {
+                            field++;
+                        }
+                        if (fields < ROW_FIELDS) {
+                            field = field < lineEnd && *field == ',' ? field + 1 : NULL;
+                        }
+                    }
+                }
+                if (fields == ROW_FIELDS && row[0] > 0 && Load_Row(cube, row[0] - 1, row[1], row[2], row[3])) {
+                    rows++;
+                    last = row[0] - 1 > last ? row[0] - 1 : last;
+                } else {
+                    rejected++;
+                }
+            }
+            at = lineEnd + 1;
+        }
+    }
+    if (readData != NULL) {
+        free(readData);
+    } else if (size > 0) {
+        munmap((void*)data, size);
+    }
+
+    //the trees are built from the daily sums in one go instead of a change for every row
+    for (int i = 0; i < cube->brands; i++) {
+        long long* tree = cube->brandFenwick + (size_t)i * cube->days;
+        for (int j = 0; j < cube->days; j++) {
+            tree[j] = cube->brandDaySales[(size_t)i * cube->days + j];
+        }
+        Fenwick_Build(tree, cube->days);
+    }
+    for (int i = 0; i < cube->types; i++) {
+        long long* tree = cube->typeFenwick + (size_t)i * cube->days;
+        for (int j = 0; j < cube->days; j++) {
+            tree[j] = cube->typeDaySales[(size_t)i * cube->days + j];
+        }
+        Fenwick_Build(tree, cube->days);
+    }
+    memcpy(cube->dayFenwick, cube->daySales, (size_t)cube->days * sizeof(long long));
+    Fenwick_Build(cube->dayFenwick, cube->days);
+    cube->bestDay = -2;
+
+    double seconds = Seconds_Now() - start;
+    printf("Loaded %lld rows (%lld rejected) in %.2f ms, %.0f rows/sec\n", rows, rejected, seconds * 1e3,
+        seconds > 0 ? (double)rows / seconds : 0.0);
+    if (last + 1 > *lastDay) {
+        *lastDay = last + 1;
+    }
+    return 1;
+}
+
+//sets one cell and the daily sums and totals around it, the cube grows for a day after its end.
+//returns 0 for a row that is not in the cube and would have to grow it past MAX_LOAD_DAYS
+int Load_Row(SalesCube* cube, int day, int brand, int type, int sales) {
+    if (day < 0 || brand < 0 || brand >= cube->brands || type < 0 || type >= cube->types) {
+        return 0;
+    }
+    if (day >= cube->days) {
+        if (day >= MAX_LOAD_DAYS) {
+            return 0;
+        }
+        //the doubling stops at the limit, so the new size never overflows
+        int grown = cube->days > MAX_LOAD_DAYS / 2 ? MAX_LOAD_DAYS : 2 * cube->days;
+        Grow_Cube(cube, grown > day ? grown : day + 1);
+    }
+    int delta = sales - CUBE_CELL(cube, day, brand, type);
+    CUBE_CELL(cube, day, brand, type) = sales;
+    cube->brandDaySales[(size_t)brand * cube->days + day] += delta;
+    cube->typeDaySales[(size_t)type * cube->days + day] += delta;
+    cube->daySales[day] += delta;
+    cube->brandTotals[brand] += delta;
+    cube->typeTotals[type] += delta;
+    cube->present[(size_t)day * cube->presentWords + brand / BITS_IN_WORD] |= 1ULL << (brand % BITS_IN_WORD);
+    return 1;
+}
+
+//reads an int from the text, returns where it ends or NULL if there is no number there
+const char* Parse_Number(const char* at, const char* end, int* number) {
+    while (at < end && (*at == ' ' || *at == '\t')) {
+        at++;
+    }
+    int negative = at < end && *at == '-';
+    if (negative) {
+        at++;
+    }
+    if (at == end || *at < '0' || *at > '9') {
+        return NULL;
+    }
+    long long value = 0;
+    while (at < end && *at >= '0' && *at <= '9') {
+        value = value * 10 + (*at - '0');
+        if (value > (long long)INT_MAX + 1) {
+            return NULL;
+        }
+        at++;
+    }
+    value = negative ? -value : value;
+    if (value > INT_MAX || value < INT_MIN) {
+        return NULL;
+    }
+    *number = (int)value;
+    return at;
+}
+
+//opens a snapshot file and maps the cube in it, nothing is read until it is used.
+//filledDays gets the days that were populated, returns NULL if the file is not a snapshot
+SalesCube* Open_Snapshot(const char* path, int* filledDays) {
+    int fd = open(path, O_RDWR);
+    struct stat info;
+    SnapshotHeader header;
+    if (fd < 0 || fstat(fd, &info) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        printf("Cannot open %s\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    SalesCube* cube = (SalesCube*)malloc(sizeof(SalesCube));
+    if (cube == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    cube->days = header.days;
+    cube->brands = header.brands;
+    cube->types = header.types;
+    //a file from a machine with another byte order fails here too, its version does not read as 1
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) != 0 || header.version != SNAPSHOT_VERSION
+        || header.days < 1 || header.brands < 1 || header.types < 1
+        || header.blockSize != (long long)Cube_Layout(cube, NULL)
+        || (long long)info.st_size < (long long)sizeof(header) + header.blockSize) {
+        printf("%s is not a snapshot of the cube\n", path);
+        free(cube);
+        close(fd);
+        return NULL;
+    }
+    cube->snapshotFd = fd;
+    if (!Map_Snapshot(cube, sizeof(header) + (size_t)header.blockSize)) {
+        printf("Cannot read %s\n", path);
+        free(cube);
+        close(fd);
+        return NULL;
+    }
+    cube->snapshotPath = Copy_Path(path, "");
+    //the best day is searched again the first time it is asked for
+    cube->bestDay = -2;
+    *filledDays = header.filledDays;
+    return cube;
+}
+
+//writes the cube to a new snapshot file and moves it there from the heap, returns 0 if the file can not be made
+int Create_Snapshot(SalesCube* cube, const char* path, int filledDays) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Cannot create %s\n", path);
+        return 0;
+    }
+    char* heapBlock = cube->block;
+    size_t blockSize = Cube_Layout(cube, NULL);
+    cube->snapshotFd = fd;
+    if (!Map_Snapshot(cube, sizeof(SnapshotHeader) + blockSize)) {
+        printf("Cannot create %s\n", path);
+        close(fd);
+        cube->snapshotFd = -1;
+        cube->block = heapBlock;
+        Cube_Layout(cube, cube->block);
+        return 0;
+    }
+    memcpy(cube->block, heapBlock, blockSize);
+    free(heapBlock);
+    cube->snapshotPath = Copy_Path(path, "");
+    memset(cube->snapshot, 0, sizeof(SnapshotHeader));
+    memcpy(cube->snapshot->magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE);
+    cube->snapshot->version = SNAPSHOT_VERSION;
+    cube->snapshot->days = cube->days;
+    cube->snapshot->brands = cube->brands;
+    cube->snapshot->types = cube->types;
+    cube->snapshot->blockSize = (long long)blockSize;
+    cube->snapshot->filledDays = filledDays;
+    return 1;
+}
+
+//maps size bytes of the snapshot file, which is made that long first, and places the cube's arrays
+//after the header. returns 0 if the file can not be mapped
+int Map_Snapshot(SalesCube* cube, size_t size) {
+    if (ftruncate(cube->snapshotFd, (off_t)size) != 0) {
+        return 0;
+    }
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cube->snapshotFd, 0);
+    if (mapping == MAP_FAILED) {
+        return 0;
+    }
+    cube->snapshot = (SnapshotHeader*)mapping;
+    cube->snapshotSize = size;
+    cube->block = (char*)mapping + sizeof(SnapshotHeader);
+    Cube_Layout(cube, cube->block);
+    return 1;
+}
+
+//writes the grown cube and the header with its new size to a new file, syncs it and renames it over the
+//snapshot, then maps the cube from it. returns 0 if the new file can not be written, the old one is left as it was.
+//the snapshot is not appendable - it keeps the block just like the cube is kept in memory, column by column,
+//so the scans run straight on the mapped file, and in that layout a new day goes inside every column.
+//every growth costs a write of the whole file, O(file size), and the doubling makes it O(log days) growths
+//over the life of the snapshot
+int Replace_Snapshot(SalesCube* grown, const SnapshotHeader* header, const char* heapBlock, size_t blockSize) {
+    char* growingPath = Copy_Path(grown->snapshotPath, SNAPSHOT_GROWING);
+    int fd = open(growingPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(growingPath);
+        return 0;
+    }
+    grown->snapshotFd = fd;
+    if (!Map_Snapshot(grown, sizeof(SnapshotHeader) + blockSize)) {
+        close(fd);
+        unlink(growingPath);
+        free(growingPath);
+        return 0;
+    }
+    memcpy(grown->block, heapBlock, blockSize);
+    *grown->snapshot = *header;
+    grown->snapshot->days = grown->days;
+    grown->snapshot->blockSize = (long long)blockSize;
+    int saved = msync(grown->snapshot, grown->snapshotSize, MS_SYNC) == 0
+        && rename(growingPath, grown->snapshotPath) == 0;
+    if (!saved) {
+        munmap(grown->snapshot, grown->snapshotSize);
+        close(fd);
+        unlink(growingPath);
+    }
+    free(growingPath);
+    return saved;
+}
+
+//a copy of the path with the suffix after it
+char* Copy_Path(const char* path, const char* suffix) {
+    char* copy = (char*)malloc(strlen(path) + strlen(suffix) + 1);
+    if (copy == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    strcpy(copy, path);
+    strcat(copy, suffix);
+    return copy;
+}
+
+//the changes are already in the file, this writes the last day and waits until it is all on the disk
+void Close_Snapshot(SalesCube* cube, int filledDays) {
+    cube->snapshot->filledDays = filledDays;
+    if (msync(cube->snapshot, cube->snapshotSize, MS_SYNC) != 0) {
+        printf("Cannot save the snapshot\n");
+    }
+}
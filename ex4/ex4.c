@@ -4,19 +4,75 @@ ID: 212730311
 Assignment: ex4
 *******************/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 //task 1
 #define ROBOT_SPACE_SIZE 20
+//a cell with more paths than 64 bits can count holds this value
+#define ROBOT_PATHS_OVERFLOW ULLONG_MAX
 
 //task 2
 #define CHEERLEADERS_WEIGHTS_SIZE 15
 #define CHEERLEADERS_LEVELS 5
-float Cheerleaders_Weights[CHEERLEADERS_WEIGHTS_SIZE] = {0};
-float cheerleaders_array[CHEERLEADERS_LEVELS][CHEERLEADERS_LEVELS];
+
+//task 3
+//the input is read in blocks of this size
+#define PARENTHESIS_BLOCK_SIZE 65536
+#define PARENTHESIS_STACK_START 64
+
+//the closing brackets that are still expected, the last one opened is on top
+typedef struct ParenthesisStack {
+    char* expected;
+    size_t depth;
+    size_t capacity;
+    //how many chars were checked so far, the position of the next char in the input
+    long long offset;
+    //the position of the first bracket that does not match, -1 while there is none
+    long long mismatch;
+} ParenthesisStack;
 
 //task 4
 #define QUEENS_SPACE_SIZE 20
+//a placed queen is marked with this char on the board
+#define QUEEN_MARK '-'
+
+//the board is kept as bitsets - bit i of a mask stands for column i (or row/region i)
+typedef struct QueensBoard {
+    int dim;
+    int regions;
+    //regionCells[region][row] - the columns in this row that belong to the region
+    unsigned int regionCells[QUEENS_SPACE_SIZE][QUEENS_SPACE_SIZE];
+    //cellRegion[row][col] - the region number of a cell
+    char cellRegion[QUEENS_SPACE_SIZE][QUEENS_SPACE_SIZE];
+    unsigned int usedRows, usedCols, usedRegions;
+    //queenCols[row] - the bit of the queen's column in this row, 0 if there is no queen yet
+    unsigned int queenCols[QUEENS_SPACE_SIZE];
+} QueensBoard;
+
+//exact cover for the queens puzzle (Algorithm X with dancing links):
+//every row, column and region is a column that must be covered exactly once, and every 2x2 block
+//is an optional column that is covered at most once - two queens that touch always share a block
+#define DLX_MAX_COLUMNS (3 * QUEENS_SPACE_SIZE + (QUEENS_SPACE_SIZE - 1) * (QUEENS_SPACE_SIZE - 1))
+//a cell covers its row, column and region and up to 4 blocks
+#define DLX_CELL_NODES 7
+#define DLX_MAX_NODES (1 + DLX_MAX_COLUMNS + QUEENS_SPACE_SIZE * QUEENS_SPACE_SIZE * DLX_CELL_NODES)
+
+typedef struct DancingLinks {
+    //node 0 is the root and nodes 1..columns are the column headers
+    int left[DLX_MAX_NODES], right[DLX_MAX_NODES], up[DLX_MAX_NODES], down[DLX_MAX_NODES];
+    int column[DLX_MAX_NODES];
+    //cell[node] - the board cell (row * dim + col) of the option this node belongs to
+    int cell[DLX_MAX_NODES];
+    int size[DLX_MAX_COLUMNS + 1];
+    int nodes;
+    long long solutions;
+    //the search stops after this many solutions, 0 counts all of them
+    long long limit;
+    //the puzzle itself, so a branch that cannot be finished is dropped before covering anything
+    const QueensBoard* board;
+} DancingLinks;
 
 //task 5
 #define PUZZLE_MAX_SIZE 30
@@ -26,38 +82,84 @@ float cheerleaders_array[CHEERLEADERS_LEVELS][CHEERLEADERS_LEVELS];
 #define X_COORDINATE 0
 #define Y_COORDINATE 1
 #define LENGTH_COORDINATE 2
+//a set of dictionary words, one bit for every word
+#define WORD_SET_SIZE ((MAX_SLOTS_SIZE + 63) / 64)
+typedef unsigned long long WordSet[WORD_SET_SIZE];
+
+//letter "at" of a slot is the same grid cell as letter "otherAt" of slot "other"
+typedef struct Crossing {
+    int other;
+    int at;
+    int otherAt;
+} Crossing;
+
+typedef struct Crossword {
+    int slots, words;
+    int slotRow[MAX_SLOTS_SIZE], slotCol[MAX_SLOTS_SIZE], slotLength[MAX_SLOTS_SIZE];
+    char slotDirection[MAX_SLOTS_SIZE];
+    //the crossings of slot i are crossings[firstCrossing[i]] up to crossings[firstCrossing[i+1]-1]
+    Crossing* crossings;
+    int firstCrossing[MAX_SLOTS_SIZE + 1];
+    //lengthWords[length] - the words of this length
+    WordSet lengthWords[STR_LEN];
+    //letterWords[position][letter] - the words with this letter at this position
+    WordSet letterWords[STR_LEN][UCHAR_MAX + 1];
+    //candidates[depth][slot] - the words a slot can still take after depth words were placed
+    WordSet* candidates;
+    int slotWord[MAX_SLOTS_SIZE];
+} Crossword;
 
 //functions
-int task1_robot_paths(char Robot_Space[][ROBOT_SPACE_SIZE], int x, int y);
-float task2_human_pyramid(int cheerleader_location, int row, int col);
-int task3_parenthesis_validator(char checkFor);
-int task4_queens_battle(char Board_Space[][QUEENS_SPACE_SIZE], char Queens_Area[QUEENS_SPACE_SIZE], int dim, int row,
-    int col,int index, int placedQueens);
-void initBoard(char Board_Space[][QUEENS_SPACE_SIZE], char Queen_Area[QUEENS_SPACE_SIZE],
-    int dim, int row, int col, char queenAreaPlace, int index);
-int isInQueenArea(char Queen_Area[QUEENS_SPACE_SIZE], int size, int index, char color);
-int isValidPoint(char Board_Space[][QUEENS_SPACE_SIZE], int row, int col, int dim, char currentColor);
-int checkCol(char Board_Space[][QUEENS_SPACE_SIZE], int col, int dim, int rowIndex);
-int checkRow(char Board_Space[][QUEENS_SPACE_SIZE], int row, int dim, int colIndex);
+unsigned long long* buildRobotPaths(const char* Robot_Space, int size);
+unsigned long long task1_robot_paths(const unsigned long long* Robot_Paths, int size, int x, int y);
+void task2_human_pyramid(float loads[], const float weights[], int level);
+int pyramidStream(int levels);
+int task3_parenthesis_validator(FILE* input, int lineOnly, long long* mismatch);
+int checkParenthesisBlock(ParenthesisStack* stack, const char* block, size_t length);
+int validateParenthesisFile(const char* path);
+int task4_queens_battle(QueensBoard* board, int placedQueens);
+int initBoard(QueensBoard* board, char Board_Space[][QUEENS_SPACE_SIZE], int dim);
+int queensCanFinish(const QueensBoard* board, unsigned int freeCells[]);
+int narrowFreeCells(const QueensBoard* board, unsigned int freeCells[]);
+unsigned int freeQueenCols(const QueensBoard* board, int row);
+int countBits(unsigned int mask);
+int lowestBit(unsigned int mask);
+void placeQueen(QueensBoard* board, int row, int col);
+void removeQueen(QueensBoard* board, int row, int col);
+void markQueens(const QueensBoard* board, char Board_Space[][QUEENS_SPACE_SIZE]);
 void printBoard(char Board_Space[][QUEENS_SPACE_SIZE], int dim);
+long long countQueensSolutions(char Board_Space[][QUEENS_SPACE_SIZE], int dim, long long limit);
+int countQueensBatch(long long limit);
+void dlxInit(DancingLinks* dlx, int primary, int secondary);
+void dlxAddRow(DancingLinks* dlx, const int columns[], int count, int cell);
+void dlxCover(DancingLinks* dlx, int col);
+void dlxUncover(DancingLinks* dlx, int col);
+void dlxSearch(DancingLinks* dlx);
+int dlxCanFinish(const DancingLinks* dlx);
 int task5_crossword_generator(char Puzzle_Grid[][PUZZLE_MAX_SIZE], int dim, char strings[][STR_LEN], int wordsInDict,
-    int slotSize, char directions[], int coordinates[][COORDINATE_SIZE],
-    int index_of_string, int index_of_direction, int wordsPlaced);
-int insertStrHor(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-    int dim, int indexOfStr, int charIndex, int x, int y);
-int insertStrVer(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-    int dim, int indexOfStr, int charIndex, int x, int y);
-void removeStrHor(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-    int dim, int indexOfStr, int charIndex, int x, int y);
-void removeStrVer(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-    int dim, int indexOfStr, int charIndex, int x, int y);
-int checkHor(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y);
-int checkVer(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y);
-
-int main()
+    int slotSize, char directions[], int coordinates[][COORDINATE_SIZE]);
+void initCrossword(Crossword* puzzle, int dim, char strings[][STR_LEN], int wordsInDict,
+    int slotSize, char directions[], int coordinates[][COORDINATE_SIZE]);
+int fillCrossword(Crossword* puzzle, char strings[][STR_LEN], int placedWords);
+int placeCrosswordWord(Crossword* puzzle, char strings[][STR_LEN], WordSet* candidates, int placedSlot, int word);
+void slotCell(const Crossword* puzzle, int slot, int letter, int* row, int* col);
+int countWords(const WordSet words);
+
+int main(int argc, char* argv[])
 {
+    //"ex4 --count-queens [max]" counts the solutions of every board given in the input instead of the menu,
+    //a max of 2 is enough to prove a board has a unique solution
+    if (argc > 1 && strcmp(argv[1], "--count-queens") == 0) {
+        return countQueensBatch(argc > 2 ? atoll(argv[2]) : 0);
+    }
+    //"ex4 --pyramid <levels>" reads a pyramid of any height level by level and prints the loads as it goes
+    if (argc > 2 && strcmp(argv[1], "--pyramid") == 0) {
+        return pyramidStream(atoi(argv[2]));
+    }
+    //"ex4 --parenthesis <path>" validates a whole file ("-" for the standard input)
+    if (argc > 2 && strcmp(argv[1], "--parenthesis") == 0) {
+        return validateParenthesisFile(argv[2]);
+    }
     //for the switch case
     int task = -1;
     //for task 1
@@ -84,9 +186,11 @@ int main()
         "#                  #",
         "####################",
     };
+    //the paths table is filled once for the whole grid and every query is a lookup
+    unsigned long long* Robot_Paths = buildRobotPaths(&Robot_Space[0][0], ROBOT_SPACE_SIZE);
     //for task 4
     char Board_Space[QUEENS_SPACE_SIZE][QUEENS_SPACE_SIZE];
-    char Queen_Area[QUEENS_SPACE_SIZE];
+    QueensBoard Queens_Board;
 
     do
     {
@@ -111,12 +215,22 @@ int main()
                 scanf("%d %d", &task1_x_given, &task1_y_given);
 
                 //to correct for the boundaries of the array "#" I will add 1
-                printf("The total number of paths the robot can take to reach home is: "
-                       "%d\n", task1_robot_paths(Robot_Space, task1_x_given+1, task1_y_given+1));
+                unsigned long long paths = task1_robot_paths(Robot_Paths, ROBOT_SPACE_SIZE,
+                    task1_x_given+1, task1_y_given+1);
+                if (paths == ROBOT_PATHS_OVERFLOW) {
+                    printf("The total number of paths the robot can take to reach home is: "
+                           "more than %llu\n", ROBOT_PATHS_OVERFLOW - 1);
+                } else {
+                    printf("The total number of paths the robot can take to reach home is: "
+                           "%llu\n", paths);
+                }
                 break;
                 }
             case 2:
                 {
+                    float Cheerleaders_Weights[CHEERLEADERS_WEIGHTS_SIZE] = {0};
+                    //the loads of the last level that was calculated, every level overwrites the one above it
+                    float Cheerleaders_Loads[CHEERLEADERS_LEVELS];
                     printf("Please enter the weights of the cheerleaders:\n");
                     //for loop just for printing and checking for a negative weight
                     int isNegative = 0;
@@ -134,21 +248,21 @@ int main()
                     printf("The total weight on each cheerleader is:\n");
                     int location = 0;
                     for (int i = 1; i <= CHEERLEADERS_LEVELS; i++) {
-                        for (int j = 1; j <= i; j++) {
-                            printf("%.2f " ,task2_human_pyramid(location,i,j));
-                            location++;
+                        task2_human_pyramid(Cheerleaders_Loads, &Cheerleaders_Weights[location], i);
+                        for (int j = 0; j < i; j++) {
+                            printf("%.2f " ,Cheerleaders_Loads[j]);
                         }
+                        location += i;
                         printf("\n");
                     }
                     break;
                 }
             case 3:
             {
-                //we will clear the buffer for using it to scan the string without making a dynamic array
-                scanf("%*[^\n]");
                 printf("Please enter a term for validation:\n");
+                //the term is the rest of the line, or the next line if nothing was typed after the option
                 scanf(" ");
-                if (task3_parenthesis_validator('\0')) {
+                if (task3_parenthesis_validator(stdin, 1, NULL)) {
                     printf("The parentheses are balanced correctly.\n");
                 } else {
                     printf("The parentheses are not balanced correctly.\n");
@@ -168,10 +282,9 @@ int main()
                         Board_Space[i][j] = areaChar;
                     }
                 }
-                // the \0 is just for some NULL char to check if the provided char is different from it
-                initBoard(Board_Space, Queen_Area, dim, 0, 0, '\0', 0);
-
-                if(task4_queens_battle(Board_Space, Queen_Area, dim, 0, 0, 0, 0)) {
+                //a solution needs exactly one region for every row and column
+                if(initBoard(&Queens_Board, Board_Space, dim) == dim && task4_queens_battle(&Queens_Board, 0)) {
+                    markQueens(&Queens_Board, Board_Space);
                     printf("Solution:\n");
                     printBoard(Board_Space, dim);
                 }
@@ -184,7 +297,7 @@ int main()
             {
                 int dim, slotSize, wordsInDict, coordinates[MAX_SLOTS_SIZE][COORDINATE_SIZE];
                 char Puzzle_Grid[PUZZLE_MAX_SIZE][PUZZLE_MAX_SIZE];
-                char strings[MAX_SLOTS_SIZE][STR_LEN], directions[STR_LEN];
+                char strings[MAX_SLOTS_SIZE][STR_LEN], directions[MAX_SLOTS_SIZE];
 
                 printf("Please enter the dimensions of the crossword grid:\n");
                 scanf("%d", &dim);
@@ -219,10 +332,8 @@ int main()
                     scanf(" %s", strings[i]);
                 }
 
-                task5_crossword_generator(Puzzle_Grid, dim, strings, wordsInDict,
-                                    slotSize, directions, coordinates, 0, 0, 0);
                 if(task5_crossword_generator(Puzzle_Grid, dim, strings, wordsInDict,
-                    slotSize, directions, coordinates, 0, 0, 0)) {
+                    slotSize, directions, coordinates)) {
                     for (int i = 0; i < dim; i++) {
                         for (int j = 0; j < dim; j++) {
                             printf("| %c ", Puzzle_Grid[i][j]);
@@ -245,206 +356,529 @@ int main()
             scanf("%*s");
         }
     } while(task != 6);
+    free(Robot_Paths);
+    return 0;
 }
 
 
 //end point for task 1 is 1,1 because the array counts the columns upside down
-int task1_robot_paths(char Robot_Space[][ROBOT_SPACE_SIZE], int x, int y)
+//the grid is a size*size block of chars ('@' is home, '#' is a wall or obstacle)
+//the robot moves from [x][y] to [x][y-1] or [x-1][y], so every cell only needs the two cells
+//before it and one pass over the grid fills the whole table
+unsigned long long* buildRobotPaths(const char* Robot_Space, int size)
 {
-    if (Robot_Space[x][y] == '@') {
-        return 1;
+    unsigned long long* Robot_Paths = (unsigned long long*)malloc((size_t)size * size * sizeof(unsigned long long));
+    if (Robot_Paths == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
     }
-    if (Robot_Space[x][y] == '#') {
-        return 0;
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) {
+            char cell = Robot_Space[x*size + y];
+            if (cell == '@') {
+                Robot_Paths[x*size + y] = 1;
+                continue;
+            }
+            if (cell == '#') {
+                Robot_Paths[x*size + y] = 0;
+                continue;
+            }
+            //outside the grid there are no paths
+            unsigned long long left = y > 0 ? Robot_Paths[x*size + y-1] : 0;
+            unsigned long long up = x > 0 ? Robot_Paths[(x-1)*size + y] : 0;
+            //once a count does not fit in 64 bits it stays stuck at the overflow value
+            if (left == ROBOT_PATHS_OVERFLOW || up == ROBOT_PATHS_OVERFLOW || left >= ROBOT_PATHS_OVERFLOW - up) {
+                Robot_Paths[x*size + y] = ROBOT_PATHS_OVERFLOW;
+            } else {
+                Robot_Paths[x*size + y] = left + up;
+            }
+        }
     }
-    return task1_robot_paths(Robot_Space, x, y-1) +
-        task1_robot_paths(Robot_Space, x-1, y);
+    return Robot_Paths;
 }
 
-float task2_human_pyramid(int cheerleader_location, int row, int col)
+unsigned long long task1_robot_paths(const unsigned long long* Robot_Paths, int size, int x, int y)
 {
-    //this function is looking at the pyramid like a 1D array
-    //we will recurse back up every time and return the sum of the above until the first cheerleader
-    if(row == 1) {
-        return Cheerleaders_Weights[cheerleader_location];
+    if (x < 0 || y < 0 || x >= size || y >= size) {
+        return 0;
     }
+    return Robot_Paths[x*size + y];
+}
 
-    //we need to go up in a different way on the sides:
-    if(col == row) {
-        return task2_human_pyramid(cheerleader_location-row, row-1, col-1)/2 +
-            Cheerleaders_Weights[cheerleader_location];
+//loads[] holds the loads of the level above (level-1 cheerleaders) and is overwritten with the loads of
+//this level, weights[] are the weights of the level's own cheerleaders.
+//every cheerleader carries her own weight and half the load of each cheerleader standing on her,
+//so a pyramid is calculated top down one level at a time with a single buffer of the bottom level's size.
+//the level is filled from right to left so loads[j-1] of the level above is still there when loads[j] needs it
+void task2_human_pyramid(float loads[], const float weights[], int level)
+{
+    if (level == 1) {
+        loads[0] = weights[0];
+        return;
     }
-    if(col == 1) {
-        return task2_human_pyramid(cheerleader_location-row+1, row-1, col)/2 +
-            Cheerleaders_Weights[cheerleader_location];
+    //we need to go up in a different way on the sides:
+    loads[level-1] = loads[level-2]/2 + weights[level-1];
+    for (int col = level-2; col > 0; col--) {
+        loads[col] = loads[col-1]/2 + loads[col]/2 + weights[col];
     }
+    loads[0] = loads[0]/2 + weights[0];
+}
 
-    return task2_human_pyramid(cheerleader_location-row, row-1, col-1)/2 +
-           task2_human_pyramid(cheerleader_location-row+1, row-1, col)/2 +
-            Cheerleaders_Weights[cheerleader_location];
+//reads the weights of a pyramid with the given number of levels from the input, level after level,
+//and prints the loads of every level as soon as it is read
+int pyramidStream(int levels)
+{
+    if (levels <= 0) {
+        printf("The pyramid needs at least one level.\n");
+        return 1;
+    }
+    float* loads = (float*)malloc((size_t)levels * sizeof(float));
+    float* weights = (float*)malloc((size_t)levels * sizeof(float));
+    if (loads == NULL || weights == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    int result = 0;
+    for (int level = 1; level <= levels && result == 0; level++) {
+        for (int i = 0; i < level; i++) {
+            if (scanf(" %f", &weights[i]) != 1) {
+                printf("The input ended before level %d was complete.\n", level);
+                result = 1;
+                break;
+            }
+            if (weights[i] < 0) {
+                printf("Negative weights are not supported.\n");
+                result = 1;
+                break;
+            }
+        }
+        if (result) {
+            break;
+        }
+        task2_human_pyramid(loads, weights, level);
+        for (int i = 0; i < level; i++) {
+            printf("%.2f ", loads[i]);
+        }
+        printf("\n");
+    }
+    free(loads);
+    free(weights);
+    return result;
 }
 
 
-int task3_parenthesis_validator(char checkFor) {
-    //char c = (char)getchar();
-    char matchingPar;
-    char c;
-    scanf("%c", &c);
-    //end of input check
-    if (c == '\0' || c == '\n') {
-        if (checkFor == '\0') {
-            return 1;
-        }
-        //if there is still another parenthesis to check at the end than it is not balanced
-        return 0;
+//checks the brackets of the input with an explicit stack, so the length of the input only costs memory
+//for the brackets that are open at the same time.
+//with lineOnly the input ends at the end of the line (the whole line is read even after a mismatch),
+//otherwise it ends at the end of the file and the reading stops at the first mismatch.
+//mismatch (if not NULL) gets the offset of the first bracket that does not match, or the length of the
+//input if some brackets are never closed, and -1 if the input is balanced
+int task3_parenthesis_validator(FILE* input, int lineOnly, long long* mismatch)
+{
+    ParenthesisStack stack = {NULL, 0, 0, 0, -1};
+    char* block = (char*)malloc(PARENTHESIS_BLOCK_SIZE);
+    if (block == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
     }
-    //found matching
-    if (c == checkFor) {
-        return 1;
+    while (1) {
+        size_t length;
+        if (lineOnly) {
+            if (fgets(block, PARENTHESIS_BLOCK_SIZE, input) == NULL) {
+                break;
+            }
+            length = strlen(block);
+        } else {
+            length = fread(block, 1, PARENTHESIS_BLOCK_SIZE, input);
+            if (length == 0) {
+                break;
+            }
+        }
+        int endOfLine = lineOnly && block[length-1] == '\n';
+        if (endOfLine) {
+            length--;
+        }
+        if (!checkParenthesisBlock(&stack, block, length) && !lineOnly) {
+            break;
+        }
+        if (endOfLine) {
+            break;
+        }
     }
-    //make a matching pair
-    if (c == '(') {
-        matchingPar = ')';
+    //if there is still another parenthesis to check at the end than it is not balanced
+    if (stack.mismatch == -1 && stack.depth > 0) {
+        stack.mismatch = stack.offset;
     }
-    else if (c == '{') {
-        matchingPar = '}';
+    if (mismatch != NULL) {
+        *mismatch = stack.mismatch;
     }
-    else if (c == '[') {
-        matchingPar = ']';
+    free(block);
+    free(stack.expected);
+    return stack.mismatch == -1;
+}
+
+//checks the next block of the input, returns 0 once a bracket does not match
+int checkParenthesisBlock(ParenthesisStack* stack, const char* block, size_t length)
+{
+    //after a mismatch the rest of the input is only counted
+    if (stack->mismatch != -1) {
+        stack->offset += (long long)length;
+        return 0;
     }
-    else if (c == '<') {
-        matchingPar = '>';
+    for (size_t i = 0; i < length; i++) {
+        char matchingPar;
+        //make a matching pair
+        switch (block[i]) {
+        case '(':
+            matchingPar = ')';
+            break;
+        case '{':
+            matchingPar = '}';
+            break;
+        case '[':
+            matchingPar = ']';
+            break;
+        case '<':
+            matchingPar = '>';
+            break;
+        case ')':
+        case '}':
+        case ']':
+        case '>':
+            //found matching
+            if (stack->depth > 0 && stack->expected[stack->depth-1] == block[i]) {
+                stack->depth--;
+                continue;
+            }
+            stack->mismatch = stack->offset + (long long)i;
+            stack->offset += (long long)length;
+            return 0;
+        default:
+            //the char is not a parenthesis than go to next char
+            continue;
+        }
+        if (stack->depth == stack->capacity) {
+            size_t capacity = stack->capacity == 0 ? PARENTHESIS_STACK_START : stack->capacity * 2;
+            char* expected = (char*)realloc(stack->expected, capacity);
+            if (expected == NULL) {
+                printf("Memory allocation error\n");
+                exit(1);
+            }
+            stack->expected = expected;
+            stack->capacity = capacity;
+        }
+        stack->expected[stack->depth++] = matchingPar;
     }
-    //if the current char is not matchiing than go back
-    else if (c == ')' || c == '}' || c == ']' || c == '>') {
-        return 0;
+    stack->offset += (long long)length;
+    return 1;
+}
+
+int validateParenthesisFile(const char* path)
+{
+    FILE* input = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (input == NULL) {
+        printf("Cannot open %s\n", path);
+        return 1;
     }
-    else {
-        //the char is not a parenthesis than go to next char
-        return task3_parenthesis_validator(checkFor);
+    long long mismatch;
+    int balanced = task3_parenthesis_validator(input, 0, &mismatch);
+    if (input != stdin) {
+        fclose(input);
     }
-    //check for next parenthesis
-    if (!task3_parenthesis_validator(matchingPar)) {
+    if (balanced) {
+        printf("The parentheses are balanced correctly.\n");
         return 0;
     }
-    //check the next input with the previous checkFor
-    return task3_parenthesis_validator(checkFor);
+    printf("The parentheses are not balanced correctly (first mismatch at offset %lld).\n", mismatch);
+    return 1;
 }
 
 
-int task4_queens_battle(char Board_Space[][QUEENS_SPACE_SIZE], char Queens_Area[QUEENS_SPACE_SIZE],
-    int dim, int row, int col, int index, int placedQueens){
+int task4_queens_battle(QueensBoard* board, int placedQueens) {
     //we placed all the queens
-    if (placedQueens == dim) {
+    if (placedQueens == board->dim) {
         return 1;
     }
-    //no solutions
-    if (index >= dim) {
-        return 0;
+    //the cells that can still take a queen in every free row
+    unsigned int freeCells[QUEENS_SPACE_SIZE] = {0};
+    for (int row = 0; row < board->dim; row++) {
+        if (board->usedRows & (1u << row)) {
+            continue;
+        }
+        freeCells[row] = freeQueenCols(board, row);
+        for (int region = 0; region < board->regions; region++) {
+            if (board->usedRegions & (1u << region)) {
+                freeCells[row] &= ~board->regionCells[region][row];
+            }
+        }
     }
-    //out of bounds
-    if (row >= dim) {
+    if (!queensCanFinish(board, freeCells)) {
         return 0;
     }
-    //out of col - next row
-    if (col >= dim) {
-        //we will use placedQueens for minimizing the board for less calculation
-        return task4_queens_battle(Board_Space, Queens_Area, dim, row+1, 0, index, placedQueens);
-    }
 
-    if (Queens_Area[index] == Board_Space[row][col] && isValidPoint(Board_Space, row, col, dim, Queens_Area[index])) {
-        char original = Board_Space[row][col]; // save the original char
-        Board_Space[row][col] = '-'; // Place the queen
-        //we  move to the next column for placing the next queen (index+1)
-        if (task4_queens_battle(Board_Space, Queens_Area, dim, 0, col + 1, index + 1, placedQueens+1)) {
-            return 1; // If successful, propagate success upwards
+    //the next queen goes to the region, row or column with the fewest free cells, so dead ends are found early
+    unsigned int bestCells[QUEENS_SPACE_SIZE] = {0};
+    int bestCount = QUEENS_SPACE_SIZE * QUEENS_SPACE_SIZE + 1;
+    for (int region = 0; region < board->regions; region++) {
+        if (board->usedRegions & (1u << region)) {
+            continue;
+        }
+        int count = 0;
+        for (int row = 0; row < board->dim; row++) {
+            count += countBits(board->regionCells[region][row] & freeCells[row]);
+        }
+        //a region with no free cell left means no solution on this branch
+        if (count == 0) {
+            return 0;
+        }
+        if (count < bestCount) {
+            bestCount = count;
+            for (int row = 0; row < board->dim; row++) {
+                bestCells[row] = board->regionCells[region][row] & freeCells[row];
+            }
+        }
+    }
+    for (int row = 0; row < board->dim; row++) {
+        if (!(board->usedRows & (1u << row)) && countBits(freeCells[row]) < bestCount) {
+            bestCount = countBits(freeCells[row]);
+            memset(bestCells, 0, sizeof(bestCells));
+            bestCells[row] = freeCells[row];
+        }
+    }
+    for (int col = 0; col < board->dim; col++) {
+        if (board->usedCols & (1u << col)) {
+            continue;
+        }
+        int count = 0;
+        for (int row = 0; row < board->dim; row++) {
+            count += (freeCells[row] >> col) & 1u;
+        }
+        if (count < bestCount) {
+            bestCount = count;
+            for (int row = 0; row < board->dim; row++) {
+                bestCells[row] = freeCells[row] & (1u << col);
+            }
         }
-
-        // reverse the change since it didn't lead to a solution
-        Board_Space[row][col] = original;
     }
-    // if placing at [row][col] did not work out we will try the next column in the same row
-    return task4_queens_battle(Board_Space, Queens_Area, dim, row, col + 1, index, placedQueens);
-
 
+    for (int row = 0; row < board->dim; row++) {
+        unsigned int cells = bestCells[row];
+        while (cells) {
+            int col = lowestBit(cells);
+            cells &= cells - 1;
+            placeQueen(board, row, col);
+            if (task4_queens_battle(board, placedQueens + 1)) {
+                return 1;
+            }
+            // reverse the change since it didn't lead to a solution
+            removeQueen(board, row, col);
+        }
+    }
+    return 0;
 }
 
-int isInQueenArea(char Queen_Area[QUEENS_SPACE_SIZE], int size, int index, char color) {
-    if (index >= size) {
-        return 1;
-    }
-    if (Queen_Area[index] == color) {
+int queensCanFinish(const QueensBoard* board, unsigned int freeCells[]) {
+    unsigned int reachedCols = 0;
+    if (!narrowFreeCells(board, freeCells)) {
         return 0;
     }
-    return isInQueenArea(Queen_Area, size, index+1, color);
+    for (int row = 0; row < board->dim; row++) {
+        //a free row or column that cannot take a queen anymore means no solution on this branch
+        if (!(board->usedRows & (1u << row)) && freeCells[row] == 0) {
+            return 0;
+        }
+        reachedCols |= freeCells[row];
+    }
+    return (reachedCols | board->usedCols) == (1u << board->dim) - 1;
 }
 
-void initBoard(char Board_Space[][QUEENS_SPACE_SIZE], char Queen_Area[QUEENS_SPACE_SIZE],
-int dim, int row, int col, char queenAreaPlace, int index) {
-    //this function is made to make a 1D array of all the different areas in the board
-    if (row >= dim) {
-        return;
+int narrowFreeCells(const QueensBoard* board, unsigned int freeCells[]) {
+    //if k regions can only use the same k rows (or columns) between them, every one of those rows
+    //gets its queen from these regions, so the other regions lose their cells there
+    unsigned int regionRows[QUEENS_SPACE_SIZE], regionCols[QUEENS_SPACE_SIZE];
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int region = 0; region < board->regions; region++) {
+            regionRows[region] = 0;
+            regionCols[region] = 0;
+            if (board->usedRegions & (1u << region)) {
+                continue;
+            }
+            for (int row = 0; row < board->dim; row++) {
+                unsigned int cells = board->regionCells[region][row] & freeCells[row];
+                if (cells) {
+                    regionRows[region] |= 1u << row;
+                    regionCols[region] |= cells;
+                }
+            }
+            if (regionRows[region] == 0) {
+                return 0;
+            }
+        }
+        for (int region = 0; region < board->regions; region++) {
+            if (board->usedRegions & (1u << region)) {
+                continue;
+            }
+            unsigned int rows = regionRows[region], cols = regionCols[region];
+            unsigned int rowsOwners = 0, colsOwners = 0;
+            for (int other = 0; other < board->regions; other++) {
+                if (board->usedRegions & (1u << other)) {
+                    continue;
+                }
+                if (!(regionRows[other] & ~rows)) {
+                    rowsOwners |= 1u << other;
+                }
+                if (!(regionCols[other] & ~cols)) {
+                    colsOwners |= 1u << other;
+                }
+            }
+            if (countBits(rowsOwners) > countBits(rows) || countBits(colsOwners) > countBits(cols)) {
+                return 0;
+            }
+            for (int other = 0; other < board->regions; other++) {
+                if (board->usedRegions & (1u << other)) {
+                    continue;
+                }
+                for (int row = 0; row < board->dim; row++) {
+                    unsigned int lost = 0;
+                    if (countBits(rowsOwners) == countBits(rows) && !(rowsOwners & (1u << other)) &&
+                        (rows & (1u << row))) {
+                        lost |= board->regionCells[other][row] & freeCells[row];
+                    }
+                    if (countBits(colsOwners) == countBits(cols) && !(colsOwners & (1u << other))) {
+                        lost |= board->regionCells[other][row] & freeCells[row] & cols;
+                    }
+                    if (lost) {
+                        freeCells[row] &= ~lost;
+                        changed = 1;
+                    }
+                }
+            }
+        }
+        //the same from the other side - k rows that can only take queens from the same k regions
+        //use up these regions, so the regions lose their cells in every other row
+        unsigned int rowRegions[QUEENS_SPACE_SIZE];
+        for (int row = 0; row < board->dim; row++) {
+            rowRegions[row] = 0;
+            for (unsigned int cells = freeCells[row]; cells; cells &= cells - 1) {
+                rowRegions[row] |= 1u << board->cellRegion[row][lowestBit(cells)];
+            }
+        }
+        for (int row = 0; row < board->dim; row++) {
+            if (board->usedRows & (1u << row)) {
+                continue;
+            }
+            unsigned int owners = 0;
+            for (int other = 0; other < board->dim; other++) {
+                if (!(board->usedRows & (1u << other)) && !(rowRegions[other] & ~rowRegions[row])) {
+                    owners |= 1u << other;
+                }
+            }
+            if (countBits(owners) > countBits(rowRegions[row])) {
+                return 0;
+            }
+            if (countBits(owners) < countBits(rowRegions[row])) {
+                continue;
+            }
+            for (int other = 0; other < board->dim; other++) {
+                if (owners & (1u << other)) {
+                    continue;
+                }
+                for (unsigned int cells = freeCells[other]; cells; cells &= cells - 1) {
+                    int col = lowestBit(cells);
+                    if (rowRegions[row] & (1u << board->cellRegion[other][col])) {
+                        freeCells[other] &= ~(1u << col);
+                        changed = 1;
+                    }
+                }
+            }
+        }
     }
-    if (col >= dim) {
-        initBoard(Board_Space, Queen_Area, dim, row+1, 0, queenAreaPlace, index);
-        return;
+    return 1;
+}
+
+int initBoard(QueensBoard* board, char Board_Space[][QUEENS_SPACE_SIZE], int dim) {
+    //this function gives every different char on the board a region number and returns how many there are
+    int regionOf[UCHAR_MAX + 1];
+    for (int i = 0; i <= UCHAR_MAX; i++) {
+        regionOf[i] = -1;
     }
-    if (isInQueenArea(Queen_Area, dim, 0, Board_Space[row][col])) {
-        Queen_Area[index] = Board_Space[row][col];
-        initBoard(Board_Space, Queen_Area, dim, row, col+1, queenAreaPlace, index+1);
-    } else {
-        initBoard(Board_Space, Queen_Area, dim, row, col+1, queenAreaPlace, index);
+    memset(board, 0, sizeof(QueensBoard));
+    board->dim = dim;
+    for (int row = 0; row < dim; row++) {
+        for (int col = 0; col < dim; col++) {
+            unsigned char color = (unsigned char)Board_Space[row][col];
+            if (regionOf[color] == -1) {
+                //more regions than rows can never be solved
+                if (board->regions == dim) {
+                    return dim + 1;
+                }
+                regionOf[color] = board->regions++;
+            }
+            board->regionCells[regionOf[color]][row] |= 1u << col;
+            board->cellRegion[row][col] = (char)regionOf[color];
+        }
     }
+    return board->regions;
 }
 
-int isValidPoint(char Board_Space[][QUEENS_SPACE_SIZE], int row, int col, int dim, char currentColor) {
-
-    if (row < 0 || col < 0 || row >= dim || col >= dim) {
-        return 0; //  out of bounds
+unsigned int freeQueenCols(const QueensBoard* board, int row) {
+    //queens may not touch, so the queens in the rows above and below block their diagonal neighbours
+    unsigned int around = 0;
+    if (row > 0) {
+        around |= board->queenCols[row-1] << 1 | board->queenCols[row-1] >> 1;
     }
-    if (currentColor != Board_Space[row][col]) {
-        return 0;
+    if (row + 1 < board->dim) {
+        around |= board->queenCols[row+1] << 1 | board->queenCols[row+1] >> 1;
     }
-    //check for all col and row
-    if (!checkCol(Board_Space, col, dim, 0) || !checkRow(Board_Space, row, dim, 0)) {
-        return 0;
+    return ~(board->usedCols | around) & ((1u << board->dim) - 1);
+}
+
+int countBits(unsigned int mask) {
+    int count = 0;
+    while (mask) {
+        mask &= mask - 1;
+        count++;
     }
+    return count;
+}
 
-    //check for around the point
-    if ((row - 1 >= 0 && col - 1 >= 0 && Board_Space[row-1][col-1] == '-') || //up left
-        (row + 1 < dim && col + 1 < dim && Board_Space[row+1][col+1] == '-') || //down right
-        (row - 1 >= 0 && col + 1 < dim && Board_Space[row-1][col+1] == '-') || //up right
-        (row + 1 < dim && col - 1 >= 0 && Board_Space[row+1][col-1] == '-')) { //down left
-        return 0;
+int lowestBit(unsigned int mask) {
+    int index = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        index++;
     }
-    return 1;
+    return index;
+}
 
+void placeQueen(QueensBoard* board, int row, int col) {
+    board->usedRows |= 1u << row;
+    board->usedCols |= 1u << col;
+    board->usedRegions |= 1u << board->cellRegion[row][col];
+    board->queenCols[row] = 1u << col;
 }
 
-int checkCol(char Board_Space[][QUEENS_SPACE_SIZE], int col, int dim, int rowIndex) {
-    if (rowIndex >= dim) {
-        return 1;
-    }
-    if (Board_Space[rowIndex][col] == '-') {
-        return 0;
-    }
-    return checkCol(Board_Space, col, dim, rowIndex + 1);
+void removeQueen(QueensBoard* board, int row, int col) {
+    board->usedRows &= ~(1u << row);
+    board->usedCols &= ~(1u << col);
+    board->usedRegions &= ~(1u << board->cellRegion[row][col]);
+    board->queenCols[row] = 0;
 }
 
-int checkRow(char Board_Space[][QUEENS_SPACE_SIZE], int row, int dim, int colIndex) {
-    if (colIndex >= dim) {
-        return 1;
-    }
-    if (Board_Space[row][colIndex] == '-') {
-        return 0;
+void markQueens(const QueensBoard* board, char Board_Space[][QUEENS_SPACE_SIZE]) {
+    for (int row = 0; row < board->dim; row++) {
+        if (board->queenCols[row]) {
+            Board_Space[row][lowestBit(board->queenCols[row])] = QUEEN_MARK;
+        }
     }
-    return checkRow(Board_Space, row, dim, colIndex + 1);
 }
 
 void printBoard(char Board_Space[][QUEENS_SPACE_SIZE], int dim){
     for (int i = 0; i < dim; i++) {
         for (int j = 0; j < dim; j++) {
-            if (Board_Space[i][j] != '-') {
+            if (Board_Space[i][j] != QUEEN_MARK) {
                 printf(" * ");
             }
             else {
@@ -455,125 +889,401 @@ void printBoard(char Board_Space[][QUEENS_SPACE_SIZE], int dim){
     }
 }
 
-int task5_crossword_generator(char Puzzle_Grid[][PUZZLE_MAX_SIZE], int dim, char strings[][STR_LEN], int wordsInDict,
-int slotSize, char directions[], int coordinates[][COORDINATE_SIZE], int index_of_string,
-int index_of_direction, int wordsPlaced) {
-    //to make it easier to see
-    int x = coordinates[index_of_direction][X_COORDINATE];
-    int y = coordinates[index_of_direction][Y_COORDINATE];
-    int placementLength = coordinates[index_of_direction][LENGTH_COORDINATE];
-    int wordLength = strlen(strings[index_of_string]);
-
-    //placed all words
-    if (wordsPlaced >= wordsInDict) {
-        return 1;
+long long countQueensSolutions(char Board_Space[][QUEENS_SPACE_SIZE], int dim, long long limit) {
+    QueensBoard board;
+    if (initBoard(&board, Board_Space, dim) != dim) {
+        return 0;
     }
-
-    if (index_of_string >= slotSize) {
-        return 1;
+    DancingLinks* dlx = (DancingLinks*)malloc(sizeof(DancingLinks));
+    if (dlx == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
     }
-
-    //went through all the slots and no place to put the word
-    if (index_of_direction >= slotSize) {
-        return 0;
+    //columns: rows are 1..dim, then the board columns, the regions and at the end the 2x2 blocks
+    dlxInit(dlx, 3 * dim, (dim - 1) * (dim - 1));
+    for (int row = 0; row < dim; row++) {
+        for (int col = 0; col < dim; col++) {
+            int columns[DLX_CELL_NODES];
+            int count = 0;
+            columns[count++] = 1 + row;
+            columns[count++] = 1 + dim + col;
+            columns[count++] = 1 + 2 * dim + board.cellRegion[row][col];
+            for (int blockRow = row - 1; blockRow <= row; blockRow++) {
+                for (int blockCol = col - 1; blockCol <= col; blockCol++) {
+                    if (blockRow >= 0 && blockCol >= 0 && blockRow < dim - 1 && blockCol < dim - 1) {
+                        columns[count++] = 1 + 3 * dim + blockRow * (dim - 1) + blockCol;
+                    }
+                }
+            }
+            dlxAddRow(dlx, columns, count, row * dim + col);
+        }
     }
+    dlx->limit = limit;
+    dlx->board = &board;
+    dlxSearch(dlx);
+    long long solutions = dlx->solutions;
+    free(dlx);
+    return solutions;
+}
 
-    if (directions[index_of_direction] == 'H' && wordLength + y <= dim && wordLength <= placementLength) {
-        if (checkHor(Puzzle_Grid, strings, dim, index_of_string, 0, x, y)) {
-            insertStrHor(Puzzle_Grid, strings, dim, index_of_string, 0, x, y);
-            if (task5_crossword_generator(Puzzle_Grid, dim, strings, wordsInDict, slotSize,
-                directions, coordinates, index_of_string+1, 0, wordsPlaced+1)) {
-                return 1; // Success
+int countQueensBatch(long long limit) {
+    //the input is a list of boards, each one is the dimension and then the board like in the menu
+    char Board_Space[QUEENS_SPACE_SIZE][QUEENS_SPACE_SIZE];
+    int dim, boardNum = 0;
+    while (scanf("%d", &dim) == 1) {
+        boardNum++;
+        if (dim < 1 || dim > QUEENS_SPACE_SIZE) {
+            printf("Board %d: the dimensions must be between 1 and %d.\n", boardNum, QUEENS_SPACE_SIZE);
+            return 1;
+        }
+        for (int i = 0; i < dim; i++) {
+            for (int j = 0; j < dim; j++) {
+                if (scanf(" %c", &Board_Space[i][j]) != 1) {
+                    printf("Board %d: the board is incomplete.\n", boardNum);
+                    return 1;
+                }
             }
-            removeStrHor(Puzzle_Grid, strings, dim, index_of_string, 0, x, y);
         }
+        long long solutions = countQueensSolutions(Board_Space, dim, limit);
+        if (limit > 0 && solutions >= limit) {
+            printf("Board %d: at least %lld solution%s\n", boardNum, solutions, solutions == 1 ? "" : "s");
+        } else if (solutions == 1) {
+            printf("Board %d: 1 solution (unique)\n", boardNum);
+        } else {
+            printf("Board %d: %lld solutions\n", boardNum, solutions);
+        }
+    }
+    return 0;
+}
 
+void dlxInit(DancingLinks* dlx, int primary, int secondary) {
+    int columns = primary + secondary;
+    for (int col = 0; col <= columns; col++) {
+        dlx->up[col] = col;
+        dlx->down[col] = col;
+        dlx->column[col] = col;
+        dlx->size[col] = 0;
+        //the secondary columns are not linked to the root, so a solution does not have to cover them
+        dlx->left[col] = col;
+        dlx->right[col] = col;
+    }
+    for (int col = 0; col <= primary; col++) {
+        dlx->left[col] = col == 0 ? primary : col - 1;
+        dlx->right[col] = col == primary ? 0 : col + 1;
     }
+    dlx->nodes = columns + 1;
+    dlx->solutions = 0;
+    dlx->limit = 0;
+    dlx->board = NULL;
+}
 
+void dlxAddRow(DancingLinks* dlx, const int columns[], int count, int cell) {
+    int first = dlx->nodes;
+    for (int i = 0; i < count; i++) {
+        int node = first + i, col = columns[i];
+        dlx->column[node] = col;
+        dlx->cell[node] = cell;
+        //add the node at the bottom of its column
+        dlx->up[node] = dlx->up[col];
+        dlx->down[node] = col;
+        dlx->down[dlx->up[col]] = node;
+        dlx->up[col] = node;
+        dlx->size[col]++;
+        //and link the row into a circle
+        dlx->left[node] = first + (i + count - 1) % count;
+        dlx->right[node] = first + (i + 1) % count;
+    }
+    dlx->nodes += count;
+}
 
-    if (directions[index_of_direction] == 'V' && wordLength + x <= dim && wordLength <= placementLength) {
-        if (checkVer(Puzzle_Grid, strings, dim, index_of_string, 0, x, y)) {
-            insertStrVer(Puzzle_Grid, strings, dim, index_of_string, 0, x, y);
-            if (task5_crossword_generator(Puzzle_Grid, dim, strings, wordsInDict, slotSize,
-                directions, coordinates, index_of_string+1, 0, wordsPlaced+1)) {
-                return 1; // Success
-            }
-            //remove the word if did not get a solution
-            removeStrVer(Puzzle_Grid, strings, dim, index_of_string, 0, x, y);
+void dlxCover(DancingLinks* dlx, int col) {
+    dlx->right[dlx->left[col]] = dlx->right[col];
+    dlx->left[dlx->right[col]] = dlx->left[col];
+    for (int row = dlx->down[col]; row != col; row = dlx->down[row]) {
+        for (int node = dlx->right[row]; node != row; node = dlx->right[node]) {
+            dlx->down[dlx->up[node]] = dlx->down[node];
+            dlx->up[dlx->down[node]] = dlx->up[node];
+            dlx->size[dlx->column[node]]--;
         }
     }
-
-
-    return task5_crossword_generator(Puzzle_Grid, dim, strings, wordsInDict,
-        slotSize, directions, coordinates, index_of_string, index_of_direction+1, wordsPlaced);
 }
 
-int insertStrHor(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y) {
+void dlxUncover(DancingLinks* dlx, int col) {
+    //exactly the reverse order of dlxCover
+    for (int row = dlx->up[col]; row != col; row = dlx->up[row]) {
+        for (int node = dlx->left[row]; node != row; node = dlx->left[node]) {
+            dlx->size[dlx->column[node]]++;
+            dlx->down[dlx->up[node]] = node;
+            dlx->up[dlx->down[node]] = node;
+        }
+    }
+    dlx->right[dlx->left[col]] = col;
+    dlx->left[dlx->right[col]] = col;
+}
 
-    if (charIndex >= (int)strlen(strings[indexOfStr])) {
-        return 1;
+void dlxSearch(DancingLinks* dlx) {
+    //every primary column is covered
+    if (dlx->right[0] == 0) {
+        dlx->solutions++;
+        return;
     }
-    if (Puzzle_Grid[x][y] != '#' && Puzzle_Grid[x][y] != strings[indexOfStr][charIndex]) {
-        return 0;
+    //branch on the column with the fewest rows left
+    int best = dlx->right[0];
+    for (int col = dlx->right[best]; col != 0; col = dlx->right[col]) {
+        if (dlx->size[col] < dlx->size[best]) {
+            best = col;
+        }
+    }
+    if (dlx->size[best] == 0 || (dlx->board != NULL && !dlxCanFinish(dlx))) {
+        return;
+    }
+    dlxCover(dlx, best);
+    for (int row = dlx->down[best]; row != best; row = dlx->down[row]) {
+        if (dlx->limit > 0 && dlx->solutions >= dlx->limit) {
+            break;
+        }
+        for (int node = dlx->right[row]; node != row; node = dlx->right[node]) {
+            dlxCover(dlx, dlx->column[node]);
+        }
+        dlxSearch(dlx);
+        for (int node = dlx->left[row]; node != row; node = dlx->left[node]) {
+            dlxUncover(dlx, dlx->column[node]);
+        }
     }
-    Puzzle_Grid[x][y] = strings[indexOfStr][charIndex];
-    return insertStrHor(Puzzle_Grid, strings, dim, indexOfStr, charIndex+1, x, y+1);
+    dlxUncover(dlx, best);
 }
 
-int insertStrVer(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y) {
+int dlxCanFinish(const DancingLinks* dlx) {
+    //plain dancing links only sees one column at a time, so the remaining options are handed to the
+    //same region/row/column counting the bitset solver uses to find dead ends early
+    QueensBoard state = *dlx->board;
+    int dim = state.dim;
+    unsigned int freeCells[QUEENS_SPACE_SIZE] = {0};
+    unsigned int all = (1u << dim) - 1;
+    state.usedRows = all;
+    state.usedCols = all;
+    state.usedRegions = all;
+    for (int col = dlx->right[0]; col != 0; col = dlx->right[col]) {
+        if (col <= dim) {
+            //a row that is still open, with the cells left in it
+            state.usedRows &= ~(1u << (col - 1));
+            for (int node = dlx->down[col]; node != col; node = dlx->down[node]) {
+                freeCells[col - 1] |= 1u << (dlx->cell[node] % dim);
+            }
+        } else if (col <= 2 * dim) {
+            state.usedCols &= ~(1u << (col - 1 - dim));
+        } else {
+            state.usedRegions &= ~(1u << (col - 1 - 2 * dim));
+        }
+    }
+    return queensCanFinish(&state, freeCells);
+}
 
-    if (charIndex >= (int)strlen(strings[indexOfStr])) {
-        return 1;
+int task5_crossword_generator(char Puzzle_Grid[][PUZZLE_MAX_SIZE], int dim, char strings[][STR_LEN], int wordsInDict,
+int slotSize, char directions[], int coordinates[][COORDINATE_SIZE]) {
+    Crossword* puzzle = (Crossword*)malloc(sizeof(Crossword));
+    if (puzzle == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
     }
-    if (Puzzle_Grid[x][y] != '#' && Puzzle_Grid[x][y] != strings[indexOfStr][charIndex]) {
-        return 0;
+    initCrossword(puzzle, dim, strings, wordsInDict, slotSize, directions, coordinates);
+    int solved = fillCrossword(puzzle, strings, 0);
+    if (solved) {
+        for (int slot = 0; slot < puzzle->slots; slot++) {
+            for (int letter = 0; letter < puzzle->slotLength[slot]; letter++) {
+                int row, col;
+                slotCell(puzzle, slot, letter, &row, &col);
+                Puzzle_Grid[row][col] = strings[puzzle->slotWord[slot]][letter];
+            }
+        }
     }
-    Puzzle_Grid[x][y] = strings[indexOfStr][charIndex];
-    return insertStrVer(Puzzle_Grid, strings, dim, indexOfStr, charIndex+1, x+1, y);
+    free(puzzle->crossings);
+    free(puzzle->candidates);
+    free(puzzle);
+    return solved;
 }
 
-void removeStrHor(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y) {
+void initCrossword(Crossword* puzzle, int dim, char strings[][STR_LEN], int wordsInDict,
+int slotSize, char directions[], int coordinates[][COORDINATE_SIZE]) {
+    memset(puzzle, 0, sizeof(Crossword));
+    puzzle->slots = slotSize;
+    puzzle->words = wordsInDict;
+    //the words are bucketed by length and by the letter at every position, once
+    for (int word = 0; word < wordsInDict; word++) {
+        int length = (int)strlen(strings[word]);
+        puzzle->lengthWords[length][word / 64] |= 1ULL << (word % 64);
+        for (int letter = 0; letter < length; letter++) {
+            unsigned char c = (unsigned char)strings[word][letter];
+            puzzle->letterWords[letter][c][word / 64] |= 1ULL << (word % 64);
+        }
+    }
+    puzzle->candidates = (WordSet*)calloc((size_t)(slotSize + 1) * slotSize + 1, sizeof(WordSet));
+    if (puzzle->candidates == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    for (int slot = 0; slot < slotSize; slot++) {
+        puzzle->slotRow[slot] = coordinates[slot][X_COORDINATE];
+        puzzle->slotCol[slot] = coordinates[slot][Y_COORDINATE];
+        puzzle->slotLength[slot] = coordinates[slot][LENGTH_COORDINATE];
+        puzzle->slotDirection[slot] = directions[slot];
+        puzzle->slotWord[slot] = -1;
+        int length = puzzle->slotLength[slot];
+        int lastRow = puzzle->slotRow[slot] + (directions[slot] == 'V' ? length - 1 : 0);
+        int lastCol = puzzle->slotCol[slot] + (directions[slot] == 'H' ? length - 1 : 0);
+        //a slot that leaves the grid or has no words of its length stays without candidates
+        if ((directions[slot] == 'H' || directions[slot] == 'V') && length > 0 && length < STR_LEN &&
+            puzzle->slotRow[slot] >= 0 && puzzle->slotCol[slot] >= 0 && lastRow < dim && lastCol < dim) {
+            memcpy(puzzle->candidates[slot], puzzle->lengthWords[length], sizeof(WordSet));
+        }
+    }
 
-    if (charIndex >= (int)strlen(strings[indexOfStr])) {
-        return;
+    //every pair of slots that share a cell gets a crossing in both directions
+    int crossingsNum = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        crossingsNum = 0;
+        for (int slot = 0; slot < slotSize; slot++) {
+            puzzle->firstCrossing[slot] = crossingsNum;
+            for (int letter = 0; letter < puzzle->slotLength[slot] && letter < PUZZLE_MAX_SIZE; letter++) {
+                int row, col;
+                slotCell(puzzle, slot, letter, &row, &col);
+                for (int other = 0; other < slotSize; other++) {
+                    int otherRow = puzzle->slotRow[other], otherCol = puzzle->slotCol[other];
+                    int otherAt = puzzle->slotDirection[other] == 'H' ? col - otherCol : row - otherRow;
+                    if (other == slot || otherAt < 0 || otherAt >= puzzle->slotLength[other] ||
+                        (puzzle->slotDirection[other] == 'H' ? row != otherRow : col != otherCol)) {
+                        continue;
+                    }
+                    //the first pass only counts the crossings
+                    if (pass == 1) {
+                        puzzle->crossings[crossingsNum].other = other;
+                        puzzle->crossings[crossingsNum].at = letter;
+                        puzzle->crossings[crossingsNum].otherAt = otherAt;
+                    }
+                    crossingsNum++;
+                }
+            }
+        }
+        puzzle->firstCrossing[slotSize] = crossingsNum;
+        if (pass == 0) {
+            puzzle->crossings = (Crossing*)malloc((size_t)(crossingsNum + 1) * sizeof(Crossing));
+            if (puzzle->crossings == NULL) {
+                printf("Memory allocation error\n");
+                exit(1);
+            }
+        }
     }
-    Puzzle_Grid[x][y] = '#';
-    removeStrHor(Puzzle_Grid, strings, dim, indexOfStr, charIndex+1, x, y+1);
 }
 
-void removeStrVer(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y) {
+int fillCrossword(Crossword* puzzle, char strings[][STR_LEN], int placedWords) {
+    //placed all words
+    if (placedWords == puzzle->slots) {
+        return 1;
+    }
+    WordSet* current = puzzle->candidates + (size_t)placedWords * puzzle->slots;
+    WordSet* next = current + puzzle->slots;
 
-    if (charIndex >= (int)strlen(strings[indexOfStr])) {
-        return;
+    //the next slot to fill is the one with the fewest candidates left
+    int bestSlot = -1, bestCount = MAX_SLOTS_SIZE + 1;
+    for (int slot = 0; slot < puzzle->slots; slot++) {
+        if (puzzle->slotWord[slot] == -1 && countWords(current[slot]) < bestCount) {
+            bestCount = countWords(current[slot]);
+            bestSlot = slot;
+        }
     }
-    Puzzle_Grid[x][y] = '#';
-    removeStrVer(Puzzle_Grid, strings, dim, indexOfStr, charIndex+1, x+1, y);
-}
 
-int checkHor(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y) {
+    for (int word = 0; word < puzzle->words; word++) {
+        if (!(current[bestSlot][word / 64] & (1ULL << (word % 64)))) {
+            continue;
+        }
+        memcpy(next, current, puzzle->slots * sizeof(WordSet));
+        puzzle->slotWord[bestSlot] = word;
+        if (placeCrosswordWord(puzzle, strings, next, bestSlot, word) &&
+            fillCrossword(puzzle, strings, placedWords + 1)) {
+            return 1; // Success
+        }
+        //remove the word if did not get a solution
+        puzzle->slotWord[bestSlot] = -1;
+    }
+    return 0;
+}
 
-    if (charIndex >= (int)strlen(strings[indexOfStr])) {
-        return 1;
+int placeCrosswordWord(Crossword* puzzle, char strings[][STR_LEN], WordSet* candidates, int placedSlot, int word) {
+    //slots whose candidates changed and whose crossing slots have to be checked again
+    int queue[MAX_SLOTS_SIZE + 1], queued[MAX_SLOTS_SIZE] = {0};
+    int head = 0, tail = 0;
+    memset(candidates[placedSlot], 0, sizeof(WordSet));
+    candidates[placedSlot][word / 64] = 1ULL << (word % 64);
+    queue[tail++] = placedSlot;
+    queued[placedSlot] = 1;
+    //the queue is a ring, a slot is never in it twice
+    //every word is used once
+    for (int slot = 0; slot < puzzle->slots; slot++) {
+        if (slot != placedSlot && puzzle->slotWord[slot] == -1 && (candidates[slot][word / 64] & (1ULL << (word % 64)))) {
+            candidates[slot][word / 64] &= ~(1ULL << (word % 64));
+            if (countWords(candidates[slot]) == 0) {
+                return 0;
+            }
+            queue[tail++] = slot;
+            queued[slot] = 1;
+        }
     }
-    if (Puzzle_Grid[x][y] != '#' && Puzzle_Grid[x][y] != strings[indexOfStr][charIndex]) {
-        return 0;
+    //a crossing slot keeps only the words that fit one of the letters still possible in the shared cell,
+    //and when that removes words its own crossings are checked again
+    while (head != tail) {
+        int slot = queue[head];
+        head = (head + 1) % (MAX_SLOTS_SIZE + 1);
+        queued[slot] = 0;
+        for (int i = puzzle->firstCrossing[slot]; i < puzzle->firstCrossing[slot + 1]; i++) {
+            const Crossing* crossing = &puzzle->crossings[i];
+            if (puzzle->slotWord[crossing->other] != -1) {
+                continue;
+            }
+            WordSet fitting = {0};
+            char seen[UCHAR_MAX + 1] = {0};
+            for (int w = 0; w < puzzle->words; w++) {
+                unsigned char c = (unsigned char)strings[w][crossing->at];
+                if ((candidates[slot][w / 64] & (1ULL << (w % 64))) && !seen[c]) {
+                    seen[c] = 1;
+                    for (int j = 0; j < WORD_SET_SIZE; j++) {
+                        fitting[j] |= puzzle->letterWords[crossing->otherAt][c][j];
+                    }
+                }
+            }
+            int changed = 0;
+            for (int j = 0; j < WORD_SET_SIZE; j++) {
+                changed |= (candidates[crossing->other][j] & ~fitting[j]) != 0;
+                candidates[crossing->other][j] &= fitting[j];
+            }
+            if (!changed) {
+                continue;
+            }
+            if (countWords(candidates[crossing->other]) == 0) {
+                return 0;
+            }
+            if (!queued[crossing->other]) {
+                queue[tail] = crossing->other;
+                tail = (tail + 1) % (MAX_SLOTS_SIZE + 1);
+                queued[crossing->other] = 1;
+            }
+        }
     }
-    return checkHor(Puzzle_Grid, strings, dim, indexOfStr, charIndex+1, x, y+1);
+    return 1;
 }
 
-int checkVer(char Puzzle_Grid[][PUZZLE_MAX_SIZE], char strings[][STR_LEN],
-int dim, int indexOfStr, int charIndex, int x, int y) {
+void slotCell(const Crossword* puzzle, int slot, int letter, int* row, int* col) {
+    *row = puzzle->slotRow[slot] + (puzzle->slotDirection[slot] == 'V' ? letter : 0);
+    *col = puzzle->slotCol[slot] + (puzzle->slotDirection[slot] == 'H' ? letter : 0);
+}
 
-    if (charIndex >= (int)strlen(strings[indexOfStr])) {
-        return 1;
-    }
-    if (Puzzle_Grid[x][y] != '#' && Puzzle_Grid[x][y] != strings[indexOfStr][charIndex]) {
-        return 0;
+int countWords(const WordSet words) {
+    int count = 0;
+    for (int i = 0; i < WORD_SET_SIZE; i++) {
+        unsigned long long bits = words[i];
+        while (bits) {
+            bits &= bits - 1;
+            count++;
+        }
     }
-    return checkVer(Puzzle_Grid, strings, dim, indexOfStr, charIndex+1, x+1, y);
-}
\ No newline at end of file
+    return count;
+}
@@ -4,29 +4,228 @@ ID: 212730311
 EX5
 *******************/
 
+//for read and fileno
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 typedef enum { FALSE, TRUE } Bool;
 
+//all the input is read through one reader, blocks of READER_BLOCK bytes go into a buffer that doubles
+//when a line does not fit, and the lines and numbers are parsed in the buffer
+#define READER_BLOCK 65536
+
+//buffer[start, end) is read and not used yet
+typedef struct LineReader {
+    int fd;
+    char* buffer;
+    size_t start, end, capacity;
+    Bool eof;
+} LineReader;
+
+LineReader input;
+
+//a binary library starts with LIBRARY_MAGIC and then has a record for every playlist, followed by a record
+//for every song of the playlist. a record starts with its kind, a string is its length and its bytes without
+//a '\0', and the numbers are ints in the byte order of the machine that wrote it:
+//playlist - LIBRARY_PLAYLIST, name
+//song - LIBRARY_SONG, year, streams, title, artist, lyrics
+#define LIBRARY_MAGIC "EX5LIB1\n"
+#define LIBRARY_MAGIC_SIZE 8
+#define LIBRARY_PLAYLIST 1
+#define LIBRARY_SONG 2
+#define EXPORT_BUFFER (1 << 20)
+
+//a json-lines library has an object on every line - {"playlist": name} starts a playlist and
+//{"title": ..., "artist": ..., "year": ..., "streams": ..., "lyrics": ...} is a song of the last playlist.
+//the keys and strings of a line are unescaped in place, only the first JSON_FIELDS fields are kept
+#define JSON_FIELDS 8
+
+typedef struct JsonField {
+    char* key;
+    size_t keyLength;
+    char* text;
+    size_t length;
+    long long number;
+    Bool isString;
+} JsonField;
+
+//every song list gets its songs and items from its own arena - slabs of SLAB_OBJECTS songs or items,
+//so a song costs no malloc of its own. the shared titles and artists are kept by the pool in chunks of
+//STRING_CHUNK bytes
+#define SLAB_OBJECTS 256
+#define STRING_CHUNK 65536
+
+//a block of memory of the arena, all the chunks of an arena are freed together
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;
+    char data[];
+} ArenaChunk;
+
+//hands out objects of one size, a released object keeps the next released one in its first bytes
+typedef struct Slab {
+    size_t objectSize;
+    char *next, *end;
+    void* released;
+} Slab;
+
+typedef struct Arena {
+    ArenaChunk* chunks;
+    Slab songs, items;
+} Arena;
+
+//counts what the arenas and the shared strings saved - every song used to take 4 mallocs and every item
+//another one, and every song had its own copy of its strings.
+//stringBytes are the bytes of all the strings songs were made with, storedBytes the bytes that were kept
+typedef struct AllocStats {
+    long long mallocs, songs, items, stringBytes, storedBytes;
+} AllocStats;
+
+AllocStats allocStats;
+
+//every title and artist is kept once in the pool's chunks and the songs point to it,
+//so two songs with the same artist have the same pointer. strings[i] is NULL for an empty place.
+//the strings are never freed one by one, so they are cut one after the other from the current chunk
+typedef struct StringPool {
+    ArenaChunk* chunks;
+    char *next, *end;
+    const char** strings;
+    unsigned* hashes;
+    size_t count, capacity;
+} StringPool;
+
+//one copy of a song's lyrics, shared by all the songs with the same lyrics and freed with the last one
+typedef struct Lyrics {
+    struct Lyrics* next;
+    unsigned hash;
+    int refs;
+    size_t size;
+    char text[];
+} Lyrics;
+
+//the lyrics by the hash of their text, in chains
+typedef struct LyricsStore {
+    Lyrics** buckets;
+    size_t count, capacity;
+} LyricsStore;
+
+StringPool namesPool;
+LyricsStore lyricsStore;
+
+//the song indexes - every song is in one group of each, indexSlots[i] is its place in the group of index i
+#define ARTIST_INDEX 0
+#define YEAR_INDEX 1
+#define TITLE_INDEX 2
+#define INDEXES 3
+
 typedef struct Song {
-    char* title;
-    char* artist;
+    const char* title;
+    const char* artist;
     int year;
-    char* lyrics;
+    Lyrics* lyrics;
     int streams;
+    //every song gets its own id, two songs with the same details are still different songs
+    int id;
+    //the playlist the song is in, for the search results
+    struct Playlist* playlist;
+    int indexSlots[INDEXES];
+    //the song's place in the heap of the top songs if inTop is TRUE, in the heap of the rest otherwise.
+    //-1 if it is in neither
+    int heapSlot;
+    Bool inTop;
 } Song;
 
+//the songs with the same key - the same artist or title (the shared pointer is the key) or the same year
+typedef struct IndexGroup {
+    uintptr_t key;
+    Song** songs;
+    int count, capacity;
+    //the streams of all the songs in the group, only kept for the artists - 0 in the other indexes
+    long long streams;
+} IndexGroup;
+
+//the groups of one index by their keys, groups[i] is NULL for an empty place
+typedef struct GroupTable {
+    IndexGroup** groups;
+    size_t count, capacity;
+} GroupTable;
+
+//the indexes are kept up to date when a song is added or freed, so a search never walks the playlists.
+//titleOrder[0, sortedTitles) is sorted by title and the title groups after it were made since the last
+//prefix search, which sorts them into place
+typedef struct SongIndex {
+    GroupTable tables[INDEXES];
+    IndexGroup** titleOrder;
+    int titleCount, sortedTitles, titleCapacity;
+} SongIndex;
+
+SongIndex songIndex;
+
+//the most streamed songs of all the playlists are kept in a min heap of TOP_SONGS songs, so the least streamed
+//of them is at its root, and all the other songs in a max heap, so the most streamed of them is at its root.
+//no song of the rest has more streams than a top song - when a play or a deletion breaks that, the two roots
+//change places, so every change is O(log n) and a report only sorts the top heap
+#define TOP_SONGS 100
+
+typedef struct SongHeap {
+    Song** songs;
+    int count, capacity;
+    //TRUE for the min heap of the top songs, FALSE for the max heap of the rest
+    Bool top;
+} SongHeap;
+
+typedef struct TopSongs {
+    SongHeap top, rest;
+} TopSongs;
+
+TopSongs topSongs = {{NULL, 0, 0, TRUE}, {NULL, 0, 0, FALSE}};
+
+//"ex5 --sketch <width>" also counts the streams of every title in a count-min sketch - depth rows of width
+//counters, a title adds to one counter of each row and its count is the smallest of them. it never counts
+//less than the real streams and takes the same memory for any number of songs
+#define SKETCH_DEPTH 4
+
+typedef struct CountMinSketch {
+    long long* counters;
+    size_t width;
+} CountMinSketch;
+
+CountMinSketch sketch;
+
 typedef int (*Comparator)(const Song*, const Song*);
 
 typedef struct SongItem{
     Song* data;
     struct SongItem* next;
+    struct SongItem* prev;
 } SongItem;
 
+//the items of a list by their places. a removed item leaves a hole instead of moving the items after it -
+//live is a Fenwick tree of the items that are still there, it finds the item in any place and takes one
+//out in O(log n). the holes are closed when the slots run out, so that is O(1) on average for every removal
+typedef struct Slots {
+    void** items;
+    //live[slot + 1] is the Fenwick tree's node of slot, capacity is always a power of 2
+    int* live;
+    //used - the slots that were given, count - the items that are not removed
+    int used, count, capacity;
+} Slots;
+
+//places holds the SongItems, the song in place i+1 of the list is found by its number without walking the list
 typedef struct {
     SongItem *head, *last;
+    Slots places;
+    //the songs and the items of the list are kept here
+    Arena* arena;
 } SongList;
 
 typedef struct Playlist {
@@ -38,10 +237,13 @@ typedef struct Playlist {
 typedef struct PlaylistItem {
     Playlist* data;
     struct PlaylistItem* next;
+    struct PlaylistItem* prev;
 } PlaylistItem;
 
+//places holds the PlaylistItems, like in SongList
 typedef struct {
     PlaylistItem *head, *last;
+    Slots places;
 } PlaylistList;
 
 PlaylistList* addPlaylistList();
@@ -49,28 +251,39 @@ SongList* addSongList(Playlist* list);
 void addPlaylistItem(PlaylistList* list, Playlist* newPlaylist);
 void addSongItem(SongList* list, Song* newSong);
 Playlist* newPlaylist(const char* name);
-Song* newSong(const char* title, const char* artist, int year, const char* lyrics);
+Song* newSong(Arena* arena, const char* title, const char* artist, int year, Lyrics* lyrics);
 void printPlaylist(Playlist* playlist);
 void printSong(SongItem* song);
-void freeSong(Song* song);
-void freeSongItem(SongItem* item);
+void freeSong(Arena* arena, Song* song);
+void freeSongItem(Arena* arena, SongItem* item);
 void freeSongList(SongList* list);
 void freePlaylist(Playlist* playlist);
 void freePlaylistItem(PlaylistItem* item);
 void freePlaylistList(PlaylistList* list);
-Bool equalPlaylist(Playlist* playlist1, Playlist* playlist2);
-Bool equalSong(const Song* song1, const Song* song2);
-void removePlaylist(PlaylistList* list, Playlist* playlist);
-void removeSong(SongList* list, Song* song);
+void removePlaylist(PlaylistList* list, int index);
+void removeSong(SongList* list, int index);
 void printPlaylistsNames(PlaylistItem* playlist, int counter);
 char* getStringInput();
-PlaylistItem* getPlaylistItemInput(PlaylistItem* playlist ,int index);
-SongItem* getSongItemInput(SongItem* song ,int index);
+void initReader(LineReader* reader, int fd);
+Bool fillReader(LineReader* reader);
+Bool skipSpaces(LineReader* reader);
+char* readLine(LineReader* reader);
+Bool readNumber(LineReader* reader, int* number);
+Bool readChoice(int* choice, int exitChoice);
+int chosenIndex(int count, int number);
+PlaylistItem* getPlaylistItemInput(PlaylistList* list, int number);
+SongItem* getSongItemInput(SongList* list, int number);
+void* growItems(void* items, int* capacity, size_t itemSize);
+void initSlots(Slots* slots);
+void appendSlot(Slots* slots, void* item);
+int findSlot(const Slots* slots, int index);
+void removeSlot(Slots* slots, int slot);
+void packSlots(Slots* slots, int capacity);
+void buildLive(Slots* slots);
 void printPlaylistsMenu();
 void printSongs(SongItem* songlist, int counter);
 void playSong(SongItem* song);
 void playAllSongs(SongItem* list);
-void switchSongs(SongItem* a, SongItem* b);
 void printSongsMenu();
 int yearCompare(const Song* song1, const Song* song2);
 void sortPlaylistByYear(SongList* list);
@@ -80,17 +293,114 @@ int streamCompareDescending(const Song* song1, const Song* song2);
 void sortPlaylistByStreamDescending(SongList* list);
 int compareAlphabetical(const Song* song1, const Song* song2);
 void sortPlaylistAlphabetical(SongList* list);
+int compareSongs(const Song* song1, const Song* song2, const Comparator keys[], int keysCount);
+void sortSongList(SongList* list, const Comparator keys[], int keysCount);
+void reindexSongList(SongList* list);
+Arena* newArena();
+void freeArena(Arena* arena);
+void* arenaChunk(ArenaChunk** chunks, size_t size);
+void freeChunks(ArenaChunk* chunk);
+void* slabAlloc(Arena* arena, Slab* slab);
+void slabFree(Slab* slab, void* object);
+char* poolString(const char* text, size_t length);
+void printAllocStats();
+unsigned hashString(const char* text, size_t length);
+const char* internString(const char* text, size_t length);
+void growStringPool();
+Lyrics* shareLyrics(const char* text, size_t length);
+void releaseLyrics(Lyrics* lyrics);
+void growLyricsStore();
+void freeSharedStrings();
+double secondsNow();
+int importLibrary(PlaylistList* playlists, const char* path);
+Bool importBinary(PlaylistList* playlists, const char* data, size_t size, long long counts[]);
+Bool importJsonLines(PlaylistList* playlists, int fd, long long counts[]);
+Playlist* importPlaylist(PlaylistList* playlists, const char* name, size_t length);
+void importSong(Playlist* playlist, const char* title, size_t titleLength, const char* artist, size_t artistLength,
+    int year, int streams, const char* lyrics, size_t lyricsLength);
+Bool takeInt(const char** at, const char* end, int* value);
+Bool takeString(const char** at, const char* end, const char** text, size_t* length);
+int parseJsonObject(char* line, JsonField fields[]);
+char* parseJsonString(char* at, char** text, size_t* length);
+long parseHex4(const char* at);
+JsonField* findJsonField(JsonField fields[], int count, const char* key);
+int exportLibrary(PlaylistList* playlists, const char* path);
+void writeBinaryString(FILE* file, const char* text, size_t length);
+void writeJsonString(FILE* file, const char* text);
+size_t poolSlot(const char* text, size_t length, unsigned hash);
+const char* findInterned(const char* text, size_t length);
+IndexGroup* findGroup(GroupTable* table, uintptr_t key, Bool create);
+void growGroupTable(GroupTable* table);
+void indexSong(Song* song, Playlist* playlist);
+void unindexSong(Song* song);
+void sortTitleIndex();
+int compareTitleGroups(const void* group1, const void* group2);
+void searchSongs();
+void printFoundSongs(const IndexGroup* group, int* counter);
+void freeSongIndex();
+void countStreams(Song* song, int streams);
+Bool streamsBefore(const Song* song1, const Song* song2);
+Bool heapBefore(const SongHeap* heap, const Song* song1, const Song* song2);
+void swapHeapSongs(SongHeap* heap, int slot1, int slot2);
+void siftHeapSong(SongHeap* heap, int slot);
+void pushHeapSong(SongHeap* heap, Song* song);
+Song* removeHeapSong(SongHeap* heap, int slot);
+void offerTopSong(Song* song);
+void dropTopSong(Song* song);
+void freeTopSongs();
+int compareTopSongs(const void* song1, const void* song2);
+void printTopSongs();
+void initSketch(size_t width);
+size_t sketchColumn(uintptr_t key, int row);
+void addToSketch(uintptr_t key, long long count);
+long long sketchCount(uintptr_t key);
+void streamsAnalytics();
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    //"ex5 --alloc-stats" prints what the arenas allocated when the program ends
+    //"ex5 --script <file>" reads the input from the file instead of stdin
+    //"ex5 --import <file>" loads a binary or json-lines library before the menu starts,
+    //"ex5 --export <file>" saves the playlists at the end - as json lines for a .jsonl or .json file, binary otherwise
+    //"ex5 --sketch <width>" counts the streams of the titles in a count-min sketch too
+    Bool showStats = FALSE;
+    const char* importPath = NULL;
+    const char* exportPath = NULL;
+    int inputFd = fileno(stdin);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--alloc-stats") == 0) {
+            showStats = TRUE;
+        } else if (i + 1 < argc && strcmp(argv[i], "--script") == 0) {
+            inputFd = open(argv[++i], O_RDONLY);
+            if (inputFd < 0) {
+                printf("Cannot open %s\n", argv[i]);
+                return 1;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "--import") == 0) {
+            importPath = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--export") == 0) {
+            exportPath = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--sketch") == 0) {
+            initSketch(strtoul(argv[++i], NULL, 10));
+        }
+    }
+    initReader(&input, inputFd);
 
     int task = -1;
     int numOfPlaylists = 0;
     PlaylistList* playlists = addPlaylistList();
+    if (importPath != NULL && importLibrary(playlists, importPath) == 0) {
+        freePlaylistList(playlists);
+        freeSharedStrings();
+        free(input.buffer);
+        return 1;
+    }
+    numOfPlaylists = playlists->places.count;
 
     do {
         printPlaylistsMenu();
-        scanf("%d", &task);
+        //the end of the input is an exit, so a library can be converted with no input at all
+        readChoice(&task, 4);
 
         switch (task)
         {
@@ -103,7 +413,7 @@ int main() {
                     printf("Choose a playlist:\n");
                     printPlaylistsNames(playlists->head, 1);
                     printf("%d. Back to main menu\n", numOfPlaylists+1);
-                    scanf("%d", &playTask);
+                    readChoice(&playTask, numOfPlaylists+1);
                     if (numOfPlaylists == 0) {
                         break;
                     }
@@ -112,11 +422,11 @@ int main() {
                     }
                     if (playTask < numOfPlaylists || playTask > 0) {
                         //inside a playlist menu
-                        item = getPlaylistItemInput(playlists->head, playTask);
+                        item = getPlaylistItemInput(playlists, playTask);
                         printf("playlist %s:\n", item->data->name);
                         do {
                             printSongsMenu();
-                            scanf("%d", &playTask);
+                            readChoice(&playTask, 6);
                             switch (playTask)
                             {
                                 case 1:
@@ -126,13 +436,12 @@ int main() {
                                     do {
                                         int songNum;
                                         printf("choose a song to play, or 0 to quit:\n");
-                                        scanf("%d", &songNum);
+                                        readChoice(&songNum, 0);
                                         if (songNum == 0) {
                                             break;
                                         }
-                                        SongItem* currentsong = getSongItemInput(item->data->songs->head, songNum);
+                                        SongItem* currentsong = getSongItemInput(item->data->songs, songNum);
                                         if (currentsong == NULL) {
-                                            freeSongItem(currentsong);
                                             exit(1);
                                         }
                                         playSong(currentsong);
@@ -147,30 +456,37 @@ int main() {
                                     int year;
                                     printf("Enter song's details\n");
                                     printf("Title: \n");
-                                    char* title = getStringInput();
-                                    if (title == NULL) {
-                                        free(title);
-                                        exit(1);
+                                    //a line from the reader is only good until the next read, so every string is
+                                    //shared right away - it is copied only if no song has it yet.
+                                    //the end of the input leaves the playlist without the song
+                                    char* line = getStringInput();
+                                    if (line == NULL) {
+                                        playTask = 6;
+                                        break;
                                     }
+                                    const char* title = internString(line, strlen(line));
                                     printf("Artist:\n");
-                                    char* artist = getStringInput();
-                                    if (artist == NULL) {
-                                        free(artist);
-                                        exit(1);
+                                    line = getStringInput();
+                                    if (line == NULL) {
+                                        playTask = 6;
+                                        break;
                                     }
+                                    const char* artist = internString(line, strlen(line));
                                     printf("Year of release:\n");
-                                    scanf("%d", &year);
+                                    if (readChoice(&year, 0) == FALSE) {
+                                        playTask = 6;
+                                        break;
+                                    }
                                     printf("Lyrics:\n");
-                                    char* lyrics = getStringInput();
-                                    if (lyrics == NULL) {
-                                        free(lyrics);
-                                        exit(1);
+                                    line = getStringInput();
+                                    if (line == NULL) {
+                                        playTask = 6;
+                                        break;
                                     }
-                                    Song* newsong = newSong(title, artist, year, lyrics);
-                                    free(title);
-                                    free(artist);
-                                    free(lyrics);
+                                    Lyrics* lyrics = shareLyrics(line, strlen(line));
+                                    Song* newsong = newSong(item->data->songs->arena, title, artist, year, lyrics);
                                     addSongItem(item->data->songs, newsong);
+                                    indexSong(newsong, item->data);
                                     item->data->songsNum++;
                                     break;
                                 }
@@ -180,12 +496,16 @@ int main() {
                                     int songTask;
                                     printSongs(item->data->songs->head,1);
                                     printf("choose a song to delete, or 0 to quit:\n");
-                                    scanf("%d", &songTask);
+                                    readChoice(&songTask, 0);
                                     if (songTask == 0) {
                                         break;
                                     }
-                                    SongItem* songToDelete = getSongItemInput(item->data->songs->head, songTask);
-                                    removeSong(item->data->songs, songToDelete->data);
+                                    SongList* songs = item->data->songs;
+                                    if (songs->places.count == 0) {
+                                        break;
+                                    }
+                                    removeSong(songs, chosenIndex(songs->places.count, songTask));
+                                    item->data->songsNum--;
                                     printf("Song deleted successfully.\n");
                                     break;
                                 }
@@ -197,7 +517,10 @@ int main() {
                                             "2. sort by streams - ascending order\n"
                                             "3. sort by streams - descending order\n"
                                             "4. sort alphabetically\n");
-                                    scanf("%d", &playTask);
+                                    //the sort menu has no way back, the end of the input leaves the playlist
+                                    if (readChoice(&playTask, 6) == FALSE) {
+                                        break;
+                                    }
                                     switch (playTask) {
                                         case 1:
                                             sortPlaylistByYear(item->data->songs);
@@ -234,9 +557,12 @@ int main() {
                 //enter a playlist
                 printf("Enter playlist's name:\n");
                 char* ch = getStringInput();
+                if (ch == NULL) {
+                    task = 4;
+                    break;
+                }
                 Playlist* list = newPlaylist(ch);
                 addPlaylistItem(playlists, list);
-                free(ch);
                 numOfPlaylists++;
                 break;
             }
@@ -244,30 +570,48 @@ int main() {
             {
                 //delete a playlist
                 int playTask = -1;
-                PlaylistItem* item;
                 PlaylistList* listcase3 = playlists;
                 printf("Choose a playlist:\n");
                 printPlaylistsNames(playlists->head, 1);
                 printf("%d. Back to main menu\n", numOfPlaylists+1);
-                scanf("%d", &playTask);
-                if (numOfPlaylists == 0) {
+                if (readChoice(&playTask, numOfPlaylists+1) == FALSE || numOfPlaylists == 0) {
                     break;
                 }
                 if (playTask <= numOfPlaylists || playTask > 0) {
                     //inside a playlist menu
-                    item = getPlaylistItemInput(playlists->head, playTask);
-                    removePlaylist(listcase3, item->data);
+                    removePlaylist(listcase3, chosenIndex(listcase3->places.count, playTask));
                     numOfPlaylists--;
                     printf("Playlist deleted.\n");
                 }
                 break;
             }
+            case 5:
+            {
+                searchSongs();
+                break;
+            }
+            case 6:
+            {
+                streamsAnalytics();
+                break;
+            }
             default:
-                scanf("%d", &task);
+                readChoice(&task, 4);
         }
     } while (task != 4);
+    if (exportPath != NULL) {
+        exportLibrary(playlists, exportPath);
+    }
     freePlaylistList(playlists);
-    printf("Goodbye!\n");  
+    freeSongIndex();
+    freeTopSongs();
+    free(sketch.counters);
+    freeSharedStrings();
+    free(input.buffer);
+    printf("Goodbye!\n");
+    if (showStats == TRUE) {
+        printAllocStats();
+    }  
 }
 
 
@@ -279,6 +623,7 @@ PlaylistList* addPlaylistList() {
     }
     sl->head = NULL;
     sl->last = NULL;
+    initSlots(&sl->places);
     return sl;
 }
 
@@ -290,6 +635,8 @@ SongList* addSongList(Playlist* list) {
     }
     sl->head = NULL;
     sl->last = NULL;
+    initSlots(&sl->places);
+    sl->arena = newArena();
     list->songs = sl;
     return sl;
 }
@@ -302,6 +649,8 @@ void addPlaylistItem(PlaylistList* list, Playlist* newPlaylist) {
     }
     item->data = newPlaylist;
     item->next = NULL;
+    item->prev = list->last;
+    appendSlot(&list->places, item);
     if (list->head == NULL)
     {
         list->head = item;
@@ -315,13 +664,12 @@ void addPlaylistItem(PlaylistList* list, Playlist* newPlaylist) {
 }
 
 void addSongItem(SongList* list, Song* newSong) {
-    SongItem* item = (SongItem*)malloc(sizeof(SongItem));
-    if(item == NULL) {
-        printf("Memory allocation error\n");
-        exit(1);
-    }
+    SongItem* item = (SongItem*)slabAlloc(list->arena, &list->arena->items);
+    allocStats.items++;
     item->data = newSong;
     item->next = NULL;
+    item->prev = list->last;
+    appendSlot(&list->places, item);
     if (list->head == NULL)
     {
         list->head = item;
@@ -347,59 +695,49 @@ Playlist* newPlaylist(const char* name) {
     return playlist;
 }
 
-Song* newSong(const char* title, const char* artist, int year, const char* lyrics) {
-    Song* song = (Song*) malloc(sizeof(Song));
-    if(song == NULL) {
-        printf("Memory allocation error\n");
-        free(song);
-        exit(1);
-    }
-    song->title = (char*) malloc(strlen(title) + 1);
-    if(song->title == NULL) {
-        printf("Memory allocation error\n");
-        free(song->title);
-        exit(1);
-    }
-    strcpy(song->title, title);
-    song->artist = (char*) malloc(strlen(artist) + 1);
-    if(song->artist == NULL) {
-        printf("Memory allocation error\n");
-        free(song->title);
-        exit(1);
-    }
-    strcpy(song->artist, artist);
+//the title and the artist are from internString and the lyrics from shareLyrics
+Song* newSong(Arena* arena, const char* title, const char* artist, int year, Lyrics* lyrics) {
+    Song* song = (Song*)slabAlloc(arena, &arena->songs);
+    song->title = title;
+    song->artist = artist;
     song->year = year;
-    song->lyrics = (char*) malloc(strlen(lyrics) + 1);
-    if(song->lyrics == NULL) {
-        printf("Memory allocation error\n");
-        free(song->lyrics);
-        exit(1);
-    }
-    strcpy(song->lyrics, lyrics);
+    song->lyrics = lyrics;
     song->streams = 0;
+    song->heapSlot = -1;
+    song->inTop = FALSE;
+    static int lastId = 0;
+    song->id = ++lastId;
+    allocStats.songs++;
     return song;
 }
 
-void freeSong(Song* song) {
+//the song's slot goes back to its slab, its title and artist stay in the pool for other songs
+void freeSong(Arena* arena, Song* song) {
     if (song != NULL) {
-        free(song->title);
-        free(song->artist);
-        free(song->lyrics);
-        free(song);
+        unindexSong(song);
+        releaseLyrics(song->lyrics);
+        slabFree(&arena->songs, song);
     }
 }
 
-
-void freeSongItem(SongItem* item) {
+void freeSongItem(Arena* arena, SongItem* item) {
     if (item != NULL) {
-        freeSong(item->data);
-        freeSongItem(item->next);
-        free(item);
+        freeSong(arena, item->data);
+        slabFree(&arena->items, item);
     }
 }
 
+//the songs and the items go with the arena, one free for every chunk instead of one for every song.
+//the list is still walked once, O(n) in its songs - every song has to leave the indexes and the top songs,
+//and give back its share of the lyrics, which other playlists' songs may still use
 void freeSongList(SongList* list) {
-    freeSongItem(list->head);
+    for (SongItem* iterator = list->head; iterator != NULL; iterator = iterator->next) {
+        unindexSong(iterator->data);
+        releaseLyrics(iterator->data->lyrics);
+    }
+    freeArena(list->arena);
+    free(list->places.items);
+    free(list->places.live);
     free(list);
 }
 
@@ -418,152 +756,314 @@ void freePlaylistItem(PlaylistItem* item) {
 
 void freePlaylistList(PlaylistList* list) {
     freePlaylistItem(list->head);
+    free(list->places.items);
+    free(list->places.live);
     free(list);
 }
 
-Bool equalPlaylist(Playlist* playlist1, Playlist* playlist2) {
-    if (playlist1->songsNum == playlist2->songsNum && strcmp(playlist1->name, playlist2->name) == 0) {
-        return TRUE;
+//unlinks the playlist in place index (from 0) and frees it
+void removePlaylist(PlaylistList* list, int index) {
+    int slot = findSlot(&list->places, index);
+    PlaylistItem* item = (PlaylistItem*)list->places.items[slot];
+    if (item->prev == NULL) {
+        list->head = item->next;
+    } else {
+        item->prev->next = item->next;
     }
-    return FALSE;
+    if (item->next == NULL) {
+        list->last = item->prev;
+    } else {
+        item->next->prev = item->prev;
+    }
+    removeSlot(&list->places, slot);
+    item->next = NULL;
+    freePlaylistItem(item);
 }
 
-Bool equalSong(const Song* song1, const Song* song2) {
-    if (song1->streams == song2->streams && song1->year == song2->year && strcmp(song1->title, song2->title) == 0) {
-        return TRUE;
+//unlinks the song in place index (from 0) and frees it
+void removeSong(SongList* list, int index) {
+    int slot = findSlot(&list->places, index);
+    SongItem* item = (SongItem*)list->places.items[slot];
+    if (item->prev == NULL) {
+        list->head = item->next;
+    } else {
+        item->prev->next = item->next;
     }
+    if (item->next == NULL) {
+        list->last = item->prev;
+    } else {
+        item->next->prev = item->prev;
+    }
+    removeSlot(&list->places, slot);
+    freeSongItem(list->arena, item);
+}
+
+void printPlaylistsNames(PlaylistItem* playlist, int counter) {
+    for (PlaylistItem* item = playlist; item != NULL; item = item->next) {
+        printf("%d. %s\n", counter, item->data->name);
+        counter++;
+    }
+}
+
+//the next line that is not empty, without the '\n' or '\r' at its end. the line is kept in the reader's buffer
+//and is good until the next read, NULL at the end of the input
+char* getStringInput() {
+    skipSpaces(&input);
+    return readLine(&input);
+}
+
+void initReader(LineReader* reader, int fd) {
+    reader->fd = fd;
+    reader->buffer = (char*)malloc(READER_BLOCK);
+    if (reader->buffer == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    reader->capacity = READER_BLOCK;
+    reader->start = reader->end = 0;
+    reader->eof = FALSE;
+}
+
+//moves what was not used to the start of the buffer and reads more after it, the buffer doubles if it is full.
+//one byte is always left for the '\0' of the last line. returns FALSE at the end of the input
+Bool fillReader(LineReader* reader) {
+    if (reader->eof == TRUE) {
+        return FALSE;
+    }
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end + 1 >= reader->capacity) {
+        char* grown = (char*)realloc(reader->buffer, reader->capacity * 2);
+        if (grown == NULL) {
+            printf("Memory allocation error\n");
+            exit(1);
+        }
+        reader->buffer = grown;
+        reader->capacity *= 2;
+    }
+    //a terminal gives a line at a time, read returns with what there is
+    ssize_t got;
+    do {
+        got = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end - 1);
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) {
+        reader->eof = TRUE;
+        return FALSE;
+    }
+    reader->end += (size_t)got;
+    return TRUE;
+}
+
+//skips spaces, tabs and newlines, returns FALSE if the input ended first
+Bool skipSpaces(LineReader* reader) {
+    do {
+        while (reader->start < reader->end && (reader->buffer[reader->start] == ' '
+            || (reader->buffer[reader->start] >= '\t' && reader->buffer[reader->start] <= '\r'))) {
+            reader->start++;
+        }
+        if (reader->start < reader->end) {
+            return TRUE;
+        }
+    } while (fillReader(reader) == TRUE);
     return FALSE;
 }
 
-void removePlaylist(PlaylistList* list, Playlist* playlist) {
-    PlaylistItem* iterator = list->head;
-    PlaylistItem* previous;
-    if (list->head && equalPlaylist(list->head->data, playlist) == TRUE){
-        list->head = iterator->next;
-        if (list->head == NULL) list->last = NULL;
-        iterator->next = NULL;
-        freePlaylistItem(iterator);
-        return;
+//the text up to the next '\n' or '\r', which is replaced by a '\0'. NULL for an empty line
+char* readLine(LineReader* reader) {
+    size_t scanned = 0;
+    char* lineEnd;
+    while ((lineEnd = (char*)memchr(reader->buffer + reader->start + scanned, '\n',
+        reader->end - reader->start - scanned)) == NULL) {
+        scanned = reader->end - reader->start;
+        if (fillReader(reader) == FALSE) {
+            //the last line of the input has no '\n'
+            lineEnd = reader->buffer + reader->end;
+            break;
+        }
     }
-    while (iterator != NULL && equalPlaylist(iterator->data, playlist) == FALSE){
-        previous = iterator;
-        iterator = iterator->next;
+    char* line = reader->buffer + reader->start;
+    char* cr = (char*)memchr(line, '\r', (size_t)(lineEnd - line));
+    if (cr != NULL) {
+        lineEnd = cr;
     }
-    if (iterator == NULL) return;
-    else if (equalPlaylist(iterator->data, playlist) == TRUE) {
-        previous->next = iterator->next;
-        iterator->next = NULL;
-        if (iterator == list->last)
-            list->last = previous;
-        freePlaylistItem(iterator);
+    reader->start = (size_t)(lineEnd - reader->buffer) + (lineEnd < reader->buffer + reader->end ? 1 : 0);
+    *lineEnd = '\0';
+    return lineEnd == line ? NULL : line;
+}
+
+//reads a menu's choice. at the end of the input the choice is exitChoice and FALSE is returned,
+//so every menu is left like its exit was chosen instead of asking again with the last choice
+Bool readChoice(int* choice, int exitChoice) {
+    if (readNumber(&input, choice) == FALSE && input.eof == TRUE) {
+        *choice = exitChoice;
+        return FALSE;
     }
+    return TRUE;
 }
 
-void removeSong(SongList* list, Song* song) {
-    SongItem* iterator = list->head;
-    SongItem* previous;
-    if (list->head && equalSong(list->head->data, song) == TRUE){
-        list->head = iterator->next;
-        if (list->head == NULL) list->last = NULL;
-        iterator->next = NULL;
-        freeSongItem(iterator);
-        return;
+//reads a number like scanf("%d") - number is not changed and the word is skipped if it is not a number
+Bool readNumber(LineReader* reader, int* number) {
+    if (skipSpaces(reader) == FALSE) {
+        return FALSE;
     }
-    while (iterator != NULL && equalSong(iterator->data, song) == FALSE){
-        previous = iterator;
-        iterator = iterator->next;
+    //a number is short, it is read into the buffer whole before it is parsed
+    while (reader->eof == FALSE && memchr(reader->buffer + reader->start, '\n', reader->end - reader->start) == NULL
+        && reader->end - reader->start < 32) {
+        fillReader(reader);
     }
-    if (iterator == NULL) return;
-    else if (equalSong(iterator->data, song) == TRUE) {
-        previous->next = iterator->next;
-        iterator->next = NULL;
-        if (iterator == list->last)
-            list->last = previous;
-        freeSongItem(iterator);
+    const char* at = reader->buffer + reader->start;
+    const char* end = reader->buffer + reader->end;
+    int negative = 0;
+    if (at < end && (*at == '-' || *at == '+')) {
+        negative = *at == '-';
+        at++;
+    }
+    long long value = 0;
+    const char* digits = at;
+    while (at < end && *at >= '0' && *at <= '9') {
+        if (value < 10000000000LL) {
+            value = value * 10 + (*at - '0');
+        }
+        at++;
     }
+    if (at == digits) {
+        while (at < end && *at != ' ' && (*at < '\t' || *at > '\r')) {
+            at++;
+        }
+        reader->start = (size_t)(at - reader->buffer);
+        return FALSE;
+    }
+    reader->start = (size_t)(at - reader->buffer);
+    *number = (int)(negative ? -value : value);
+    return TRUE;
 }
 
-void printPlaylistsNames(PlaylistItem* playlist, int counter) {
-    PlaylistItem* item = playlist;
-    if (item == NULL) {
-        return;
+//the place (from 0) of the item the user chose by its number, a number out of the list chooses the last item
+int chosenIndex(int count, int number) {
+    if (number >= 1 && number <= count) {
+        return number - 1;
     }
-    if (item->next != NULL) {
+    return count - 1;
+}
 
-        printf("%d. %s\n", counter, item->data->name);
+PlaylistItem* getPlaylistItemInput(PlaylistList* list, int number) {
+    if (list->places.count == 0) {
+        return NULL;
+    }
+    return (PlaylistItem*)list->places.items[findSlot(&list->places, chosenIndex(list->places.count, number))];
+}
 
-        counter++;
-        printPlaylistsNames(item->next, counter);
+SongItem* getSongItemInput(SongList* list, int number) {
+    if (list->places.count == 0) {
+        return NULL;
     }
-    else {
-        printf("%d. %s\n", counter, item->data->name);
+    return (SongItem*)list->places.items[findSlot(&list->places, chosenIndex(list->places.count, number))];
+}
+
+//doubles an items array, returns the new array
+void* growItems(void* items, int* capacity, size_t itemSize) {
+    int newCapacity = *capacity == 0 ? 8 : *capacity * 2;
+    void* grown = realloc(items, (size_t)newCapacity * itemSize);
+    if (grown == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
     }
+    *capacity = newCapacity;
+    return grown;
+}
 
+void initSlots(Slots* slots) {
+    slots->items = NULL;
+    slots->live = NULL;
+    slots->used = 0;
+    slots->count = 0;
+    slots->capacity = 0;
 }
 
-char* getStringInput() {
-    char ch;
-    int num = 0;
-    char *newstring = NULL, *temp = NULL;
-
-    scanf(" ");
-    while ((ch = (char)getchar()) != '\n' && ch != '\r') {
-        ++num;
-        temp = (char*)realloc(newstring, (num + 1) * sizeof(char));
-        if(temp == NULL) {
-            free(newstring);
-            printf("Memory allocation error\n");
-            exit(1);
+//puts the item in the place after the last one, the holes are closed first if there is no slot left
+void appendSlot(Slots* slots, void* item) {
+    if (slots->used == slots->capacity) {
+        //more than half holes are closed in the same room, otherwise the room doubles
+        int capacity = slots->capacity == 0 ? 8 : slots->count * 2 <= slots->capacity ? slots->capacity
+            : slots->capacity * 2;
+        packSlots(slots, capacity);
+    }
+    int slot = slots->used++;
+    slots->items[slot] = item;
+    slots->count++;
+    for (int node = slot + 1; node <= slots->capacity; node += node & -node) {
+        slots->live[node]++;
+    }
+}
+
+//the slot of the item in place index (from 0) - the tree is walked down from its top node
+int findSlot(const Slots* slots, int index) {
+    int node = 0;
+    int left = index + 1;
+    for (int step = slots->capacity; step > 0; step /= 2) {
+        if (node + step <= slots->capacity && slots->live[node + step] < left) {
+            node += step;
+            left -= slots->live[node];
         }
-        newstring = temp;
-        newstring[num - 1] = ch;
     }
-    if (num > 0) {
-        newstring[num] = '\0';
-    } else {
-        free(newstring);
-        newstring = NULL;
+    return node;
+}
+
+void removeSlot(Slots* slots, int slot) {
+    slots->items[slot] = NULL;
+    slots->count--;
+    for (int node = slot + 1; node <= slots->capacity; node += node & -node) {
+        slots->live[node]--;
     }
-    return newstring;
 }
 
-PlaylistItem* getPlaylistItemInput(PlaylistItem* playlist ,int index) {
-    PlaylistItem* list = playlist;
-    if (list == NULL) {
-        return NULL;
+//moves the items to the first slots in their order and builds the tree for the new capacity
+void packSlots(Slots* slots, int capacity) {
+    int used = 0;
+    for (int i = 0; i < slots->used; i++) {
+        if (slots->items[i] != NULL) {
+            slots->items[used++] = slots->items[i];
+        }
     }
-    if (list->next != NULL) {
-        if (index == 1) {
-            return list;
+    if (capacity != slots->capacity) {
+        void** items = (void**)realloc(slots->items, (size_t)capacity * sizeof(void*));
+        int* live = (int*)realloc(slots->live, (size_t)(capacity + 1) * sizeof(int));
+        if (items == NULL || live == NULL) {
+            printf("Memory allocation error\n");
+            exit(1);
         }
-        return getPlaylistItemInput(list->next, --index);
+        slots->items = items;
+        slots->live = live;
+        slots->capacity = capacity;
     }
-    return list;
+    slots->used = used;
+    buildLive(slots);
 }
 
-SongItem* getSongItemInput(SongItem* song ,int index) {
-    SongItem* list = song;
-    if (list == NULL) {
-        return NULL;
+//builds the tree from the used slots in O(n), every node adds itself to its parent
+void buildLive(Slots* slots) {
+    slots->live[0] = 0;
+    for (int node = 1; node <= slots->capacity; node++) {
+        slots->live[node] = node <= slots->used && slots->items[node - 1] != NULL ? 1 : 0;
     }
-    if (list->next != NULL) {
-        if (index == 1) {
-            return list;
+    for (int node = 1; node <= slots->capacity; node++) {
+        int parent = node + (node & -node);
+        if (parent <= slots->capacity) {
+            slots->live[parent] += slots->live[node];
         }
-        return getSongItemInput(list->next, --index);
     }
-    return list;
 }
 
 void printSongs(SongItem* songlist, int counter) {
-    SongItem* iterator = songlist;
-    if (iterator != NULL) {
+    for (SongItem* iterator = songlist; iterator != NULL; iterator = iterator->next) {
         printf("%d. Title: %s\n", counter, iterator->data->title);
         printf("\tArtist: %s\n" , iterator->data->artist);
         printf("\tReleased: %d\n", iterator->data->year);
         printf("\tStreams: %d\n\n", iterator->data->streams);
         counter++;
-        printSongs(iterator->next, counter);
     }
 }
 
@@ -571,46 +1071,24 @@ void playSong(SongItem* song) {
     SongItem* iterator = song;
     if (iterator != NULL) {
         printf("Now playing %s:\n", iterator->data->title);
-        printf("$ %s $\n\n", iterator->data->lyrics);
-        iterator->data->streams++;
+        printf("$ %s $\n\n", iterator->data->lyrics->text);
+        countStreams(iterator->data, 1);
     }
 }
 
 void playAllSongs(SongItem* list) {
-    SongItem* iterator = list;
-    if (iterator->next != NULL) {
-        playSong(iterator);
-        playAllSongs(iterator->next);
-    }
-    if (iterator->next == NULL) {
+    for (SongItem* iterator = list; iterator != NULL; iterator = iterator->next) {
         playSong(iterator);
     }
 }
 
-void switchSongs(SongItem* a, SongItem* b) {
-    Song* temp = a->data;
-    a->data = b->data;
-    b->data = temp;
-}
-
 int yearCompare(const Song* song1, const Song* song2) {
     return song1->year - song2->year;
 }
 
 void sortPlaylistByYear(SongList* list){
-    SongItem* i = NULL;
-    Bool switched = TRUE;
-    while (switched == TRUE){
-        switched = FALSE;
-        i = list->head;
-        while (i->next != NULL){
-            if (yearCompare(i->data, i->next->data)>0){
-                switched = TRUE;
-                switchSongs(i, i->next);
-            }
-            i = i->next;
-        }
-    }
+    Comparator keys[] = {yearCompare};
+    sortSongList(list, keys, 1);
     printf("sorted\n");
 }
 
@@ -619,19 +1097,8 @@ int streamCompareAscending(const Song* song1, const Song* song2) {
 }
 
 void sortPlaylistByStreamAscending(SongList* list){
-    SongItem* i = NULL;
-    Bool switched = TRUE;
-    while (switched == TRUE){
-        switched = FALSE;
-        i = list->head;
-        while (i->next != NULL){
-            if (streamCompareAscending(i->data, i->next->data)>0){
-                switched = TRUE;
-                switchSongs(i, i->next);
-            }
-            i = i->next;
-        }
-    }
+    Comparator keys[] = {streamCompareAscending};
+    sortSongList(list, keys, 1);
     printf("sorted\n");
 }
 
@@ -640,46 +1107,1219 @@ int streamCompareDescending( const Song* song1, const Song* song2) {
 }
 
 void sortPlaylistByStreamDescending(SongList* list){
-    SongItem* i = NULL;
-    Bool switched = TRUE;
-    while (switched == TRUE){
-        switched = FALSE;
-        i = list->head;
-        while (i->next != NULL){
-            if (streamCompareDescending(i->data, i->next->data)>0){
-                switched = TRUE;
-                switchSongs(i, i->next);
-            }
-            i = i->next;
-        }
-    }
+    Comparator keys[] = {streamCompareDescending};
+    sortSongList(list, keys, 1);
     printf("sorted\n");
 }
 
 int compareAlphabetical(const Song* song1, const Song* song2) {
+    //the titles are shared, the same title is the same pointer
+    if (song1->title == song2->title) {
+        return 0;
+    }
     return strcmp(song1->title, song2->title);
 }
 
 void sortPlaylistAlphabetical(SongList* list){
-    SongItem* i = NULL;
-    Bool switched = TRUE;
-    while (switched == TRUE){
-        switched = FALSE;
-        i = list->head;
-        while (i->next != NULL){
-            if (compareAlphabetical(i->data, i->next->data)>0){
-                switched = TRUE;
-                switchSongs(i, i->next);
+    Comparator keys[] = {compareAlphabetical};
+    sortSongList(list, keys, 1);
+    printf("sorted\n");
+}
+
+//compares by the first key, every next key is used only when the keys before it found the songs equal
+int compareSongs(const Song* song1, const Song* song2, const Comparator keys[], int keysCount) {
+    for (int i = 0; i < keysCount; i++) {
+        int result = keys[i](song1, song2);
+        if (result != 0) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+//a stable bottom up merge sort - runs of 1, 2, 4... items are merged by relinking the items until
+//the whole list is one run. no song is copied and no memory is allocated
+void sortSongList(SongList* list, const Comparator keys[], int keysCount) {
+    SongItem* head = list->head;
+    SongItem* tail = NULL;
+    int merges = 2;
+    for (int width = 1; head != NULL && merges > 1; width *= 2) {
+        SongItem* rest = head;
+        head = NULL;
+        tail = NULL;
+        merges = 0;
+        while (rest != NULL) {
+            //the left run starts at rest and the right run right after it
+            SongItem* left = rest;
+            SongItem* right = rest;
+            int leftSize = 0, rightSize = width;
+            while (right != NULL && leftSize < width) {
+                right = right->next;
+                leftSize++;
+            }
+            while (leftSize > 0 || (rightSize > 0 && right != NULL)) {
+                SongItem* next;
+                //on equal songs the left one goes first, that keeps the sort stable
+                if (leftSize > 0 && (rightSize == 0 || right == NULL
+                    || compareSongs(left->data, right->data, keys, keysCount) <= 0)) {
+                    next = left;
+                    left = left->next;
+                    leftSize--;
+                } else {
+                    next = right;
+                    right = right->next;
+                    rightSize--;
+                }
+                if (tail == NULL) {
+                    head = next;
+                } else {
+                    tail->next = next;
+                }
+                tail = next;
             }
-            i = i->next;
+            rest = right;
+            merges++;
         }
+        tail->next = NULL;
+    }
+    list->head = head;
+    list->last = tail != NULL ? tail : list->last;
+    reindexSongList(list);
+}
+
+//sets the prev links and the slots again after the list was relinked, the holes are gone after it
+void reindexSongList(SongList* list) {
+    SongItem* prev = NULL;
+    int i = 0;
+    for (SongItem* iterator = list->head; iterator != NULL; iterator = iterator->next) {
+        iterator->prev = prev;
+        list->places.items[i++] = iterator;
+        prev = iterator;
+    }
+    list->places.used = i;
+    if (list->places.capacity > 0) {
+        buildLive(&list->places);
+    }
+}
+
+Arena* newArena() {
+    Arena* arena = (Arena*)malloc(sizeof(Arena));
+    if (arena == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    allocStats.mallocs++;
+    arena->chunks = NULL;
+    arena->songs.objectSize = sizeof(Song);
+    arena->items.objectSize = sizeof(SongItem);
+    arena->songs.next = arena->songs.end = NULL;
+    arena->items.next = arena->items.end = NULL;
+    arena->songs.released = arena->items.released = NULL;
+    return arena;
+}
+
+void freeArena(Arena* arena) {
+    freeChunks(arena->chunks);
+    free(arena);
+}
+
+void freeChunks(ArenaChunk* chunk) {
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+//a new chunk of size bytes at the head of the chunks list, an arena's or the pool's
+void* arenaChunk(ArenaChunk** chunks, size_t size) {
+    ArenaChunk* chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+    if (chunk == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    allocStats.mallocs++;
+    chunk->size = size;
+    chunk->next = *chunks;
+    *chunks = chunk;
+    return chunk->data;
+}
+
+//a released object if there is one, otherwise the next one of the slab
+void* slabAlloc(Arena* arena, Slab* slab) {
+    if (slab->released != NULL) {
+        void* object = slab->released;
+        slab->released = *(void**)object;
+        return object;
+    }
+    if (slab->next == slab->end) {
+        slab->next = (char*)arenaChunk(&arena->chunks, slab->objectSize * SLAB_OBJECTS);
+        slab->end = slab->next + slab->objectSize * SLAB_OBJECTS;
+    }
+    void* object = slab->next;
+    slab->next += slab->objectSize;
+    return object;
+}
+
+void slabFree(Slab* slab, void* object) {
+    *(void**)object = slab->released;
+    slab->released = object;
+}
+
+//copies length bytes of text and a '\0' to the pool's current chunk, a string longer than a quarter of a chunk
+//gets a chunk of its own so the rest of the current chunk is not wasted
+char* poolString(const char* text, size_t length) {
+    size_t size = length + 1;
+    char* copy;
+    if (size > STRING_CHUNK / 4) {
+        copy = (char*)arenaChunk(&namesPool.chunks, size);
+    } else {
+        if ((size_t)(namesPool.end - namesPool.next) < size) {
+            namesPool.next = (char*)arenaChunk(&namesPool.chunks, STRING_CHUNK);
+            namesPool.end = namesPool.next + STRING_CHUNK;
+        }
+        copy = namesPool.next;
+        namesPool.next += size;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void printAllocStats() {
+    printf("%lld songs and %lld items took %lld mallocs, one for each song and string would take %lld\n",
+        allocStats.songs, allocStats.items, allocStats.mallocs, allocStats.songs * 4 + allocStats.items);
+    printf("%lld bytes of titles, artists and lyrics were kept in %lld bytes, sharing saved %lld bytes\n",
+        allocStats.stringBytes, allocStats.storedBytes, allocStats.stringBytes - allocStats.storedBytes);
+}
+
+//FNV-1a of length bytes of text
+unsigned hashString(const char* text, size_t length) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//the pool's copy of length bytes of text, made the first time the string is seen.
+//the text does not need a '\0' so strings can be taken straight from a file
+const char* internString(const char* text, size_t length) {
+    size_t size = length + 1;
+    unsigned hash = hashString(text, length);
+    allocStats.stringBytes += (long long)size;
+    if (namesPool.count * 10 >= namesPool.capacity * 7) {
+        growStringPool();
+    }
+    size_t i = poolSlot(text, length, hash);
+    if (namesPool.strings[i] != NULL) {
+        return namesPool.strings[i];
+    }
+    namesPool.strings[i] = poolString(text, length);
+    namesPool.hashes[i] = hash;
+    namesPool.count++;
+    allocStats.storedBytes += (long long)size;
+    return namesPool.strings[i];
+}
+
+//the place of the string in the pool, or the empty place it would go to
+size_t poolSlot(const char* text, size_t length, unsigned hash) {
+    size_t i = hash & (namesPool.capacity - 1);
+    while (namesPool.strings[i] != NULL) {
+        if (namesPool.hashes[i] == hash && strncmp(namesPool.strings[i], text, length) == 0
+            && namesPool.strings[i][length] == '\0') {
+            return i;
+        }
+        i = (i + 1) & (namesPool.capacity - 1);
+    }
+    return i;
+}
+
+//the pool's copy of the string, NULL if no song was ever made with it
+const char* findInterned(const char* text, size_t length) {
+    if (namesPool.capacity == 0) {
+        return NULL;
+    }
+    return namesPool.strings[poolSlot(text, length, hashString(text, length))];
+}
+
+//doubles the pool's table, the first call makes it
+void growStringPool() {
+    size_t capacity = namesPool.capacity == 0 ? 1024 : namesPool.capacity * 2;
+    const char** strings = (const char**)calloc(capacity, sizeof(const char*));
+    unsigned* hashes = (unsigned*)malloc(capacity * sizeof(unsigned));
+    if (strings == NULL || hashes == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < namesPool.capacity; i++) {
+        if (namesPool.strings[i] != NULL) {
+            size_t j = namesPool.hashes[i] & (capacity - 1);
+            while (strings[j] != NULL) {
+                j = (j + 1) & (capacity - 1);
+            }
+            strings[j] = namesPool.strings[i];
+            hashes[j] = namesPool.hashes[i];
+        }
+    }
+    free(namesPool.strings);
+    free(namesPool.hashes);
+    namesPool.strings = strings;
+    namesPool.hashes = hashes;
+    namesPool.capacity = capacity;
+}
+
+//the shared copy of length bytes of lyrics with one more reference, made if no song has these lyrics yet
+Lyrics* shareLyrics(const char* text, size_t length) {
+    size_t size = length + 1;
+    unsigned hash = hashString(text, length);
+    allocStats.stringBytes += (long long)size;
+    if (lyricsStore.count >= lyricsStore.capacity) {
+        growLyricsStore();
+    }
+    Lyrics** bucket = &lyricsStore.buckets[hash & (lyricsStore.capacity - 1)];
+    for (Lyrics* lyrics = *bucket; lyrics != NULL; lyrics = lyrics->next) {
+        if (lyrics->hash == hash && lyrics->size == size && memcmp(lyrics->text, text, length) == 0) {
+            lyrics->refs++;
+            return lyrics;
+        }
+    }
+    Lyrics* lyrics = (Lyrics*)malloc(sizeof(Lyrics) + size);
+    if (lyrics == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    allocStats.mallocs++;
+    allocStats.storedBytes += (long long)size;
+    memcpy(lyrics->text, text, length);
+    lyrics->text[length] = '\0';
+    lyrics->hash = hash;
+    lyrics->size = size;
+    lyrics->refs = 1;
+    lyrics->next = *bucket;
+    *bucket = lyrics;
+    lyricsStore.count++;
+    return lyrics;
+}
+
+//drops a reference, the last song with the lyrics frees them
+void releaseLyrics(Lyrics* lyrics) {
+    if (--lyrics->refs > 0) {
+        return;
+    }
+    Lyrics** link = &lyricsStore.buckets[lyrics->hash & (lyricsStore.capacity - 1)];
+    while (*link != lyrics) {
+        link = &(*link)->next;
+    }
+    *link = lyrics->next;
+    lyricsStore.count--;
+    free(lyrics);
+}
+
+//doubles the buckets, the first call makes them
+void growLyricsStore() {
+    size_t capacity = lyricsStore.capacity == 0 ? 1024 : lyricsStore.capacity * 2;
+    Lyrics** buckets = (Lyrics**)calloc(capacity, sizeof(Lyrics*));
+    if (buckets == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < lyricsStore.capacity; i++) {
+        Lyrics* lyrics = lyricsStore.buckets[i];
+        while (lyrics != NULL) {
+            Lyrics* next = lyrics->next;
+            lyrics->next = buckets[lyrics->hash & (capacity - 1)];
+            buckets[lyrics->hash & (capacity - 1)] = lyrics;
+            lyrics = next;
+        }
+    }
+    free(lyricsStore.buckets);
+    lyricsStore.buckets = buckets;
+    lyricsStore.capacity = capacity;
+}
+
+//the lyrics were all freed with their songs, only the tables and the pool's strings are left
+void freeSharedStrings() {
+    freeChunks(namesPool.chunks);
+    free(namesPool.strings);
+    free(namesPool.hashes);
+    free(lyricsStore.buckets);
+}
+
+double secondsNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+//adds the playlists of a library file after the ones there are, returns 0 if the file can not be read.
+//a binary file is mapped and its strings are shared straight from the mapping, a json-lines file is read
+//through a LineReader a block at a time, so neither is ever held in memory whole
+int importLibrary(PlaylistList* playlists, const char* path) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Cannot open %s\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+    double start = secondsNow();
+    //playlists and songs
+    long long counts[2] = {0, 0};
+    Bool complete;
+    size_t size = (size_t)info.st_size;
+    char magic[LIBRARY_MAGIC_SIZE];
+    if (size >= LIBRARY_MAGIC_SIZE && pread(fd, magic, LIBRARY_MAGIC_SIZE, 0) == LIBRARY_MAGIC_SIZE
+        && memcmp(magic, LIBRARY_MAGIC, LIBRARY_MAGIC_SIZE) == 0) {
+        const char* data = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            printf("Cannot read %s\n", path);
+            return 0;
+        }
+        posix_madvise((void*)data, size, POSIX_MADV_SEQUENTIAL);
+        complete = importBinary(playlists, data, size, counts);
+        munmap((void*)data, size);
+    } else {
+        complete = importJsonLines(playlists, fd, counts);
+        close(fd);
+    }
+    double seconds = secondsNow() - start;
+    if (complete == FALSE) {
+        printf("%s is damaged, only what came before the damage was imported\n", path);
+    }
+    printf("Imported %lld playlists and %lld songs in %.2f ms\n", counts[0], counts[1], seconds * 1e3);
+    return 1;
+}
+
+//returns FALSE if a record is cut or unknown, everything before it stays imported
+Bool importBinary(PlaylistList* playlists, const char* data, size_t size, long long counts[]) {
+    const char* at = data + LIBRARY_MAGIC_SIZE;
+    const char* end = data + size;
+    Playlist* playlist = NULL;
+    while (at < end) {
+        int kind;
+        if (takeInt(&at, end, &kind) == FALSE) {
+            return FALSE;
+        }
+        if (kind == LIBRARY_PLAYLIST) {
+            const char* name;
+            size_t length;
+            if (takeString(&at, end, &name, &length) == FALSE) {
+                return FALSE;
+            }
+            playlist = importPlaylist(playlists, name, length);
+            counts[0]++;
+        } else if (kind == LIBRARY_SONG && playlist != NULL) {
+            int year, streams;
+            const char *title, *artist, *lyrics;
+            size_t titleLength, artistLength, lyricsLength;
+            if (takeInt(&at, end, &year) == FALSE || takeInt(&at, end, &streams) == FALSE
+                || takeString(&at, end, &title, &titleLength) == FALSE
+                || takeString(&at, end, &artist, &artistLength) == FALSE
+                || takeString(&at, end, &lyrics, &lyricsLength) == FALSE) {
+                return FALSE;
+            }
+            importSong(playlist, title, titleLength, artist, artistLength, year, streams, lyrics, lyricsLength);
+            counts[1]++;
+        } else {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//returns FALSE if a line is not an object of a playlist or a song, everything before it stays imported
+Bool importJsonLines(PlaylistList* playlists, int fd, long long counts[]) {
+    LineReader reader;
+    initReader(&reader, fd);
+    Playlist* playlist = NULL;
+    Bool complete = TRUE;
+    while (complete == TRUE && skipSpaces(&reader) == TRUE) {
+        JsonField fields[JSON_FIELDS];
+        char* line = readLine(&reader);
+        int count = line == NULL ? -1 : parseJsonObject(line, fields);
+        JsonField* name = findJsonField(fields, count, "playlist");
+        JsonField* title = findJsonField(fields, count, "title");
+        JsonField* artist = findJsonField(fields, count, "artist");
+        JsonField* lyrics = findJsonField(fields, count, "lyrics");
+        JsonField* year = findJsonField(fields, count, "year");
+        JsonField* streams = findJsonField(fields, count, "streams");
+        if (name != NULL && name->isString == TRUE) {
+            playlist = importPlaylist(playlists, name->text, name->length);
+            counts[0]++;
+        } else if (playlist != NULL && title != NULL && title->isString == TRUE && artist != NULL
+            && artist->isString == TRUE && lyrics != NULL && lyrics->isString == TRUE) {
+            importSong(playlist, title->text, title->length, artist->text, artist->length,
+                year != NULL ? (int)year->number : 0, streams != NULL ? (int)streams->number : 0,
+                lyrics->text, lyrics->length);
+            counts[1]++;
+        } else {
+            complete = FALSE;
+        }
+    }
+    free(reader.buffer);
+    return complete;
+}
+
+Playlist* importPlaylist(PlaylistList* playlists, const char* name, size_t length) {
+    char* copy = (char*)malloc(length + 1);
+    if (copy == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+    Playlist* playlist = newPlaylist(copy);
+    free(copy);
+    addPlaylistItem(playlists, playlist);
+    return playlist;
+}
+
+void importSong(Playlist* playlist, const char* title, size_t titleLength, const char* artist, size_t artistLength,
+    int year, int streams, const char* lyrics, size_t lyricsLength) {
+    Song* song = newSong(playlist->songs->arena, internString(title, titleLength), internString(artist, artistLength),
+        year, shareLyrics(lyrics, lyricsLength));
+    song->streams = streams;
+    addSongItem(playlist->songs, song);
+    indexSong(song, playlist);
+    playlist->songsNum++;
+}
+
+//reads an int of a binary library and moves after it, FALSE if the file ends first
+Bool takeInt(const char** at, const char* end, int* value) {
+    if ((size_t)(end - *at) < sizeof(int)) {
+        return FALSE;
+    }
+    memcpy(value, *at, sizeof(int));
+    *at += sizeof(int);
+    return TRUE;
+}
+
+//a string of a binary library is left where it is, text points to its bytes in the file
+Bool takeString(const char** at, const char* end, const char** text, size_t* length) {
+    int size;
+    if (takeInt(at, end, &size) == FALSE || size < 0 || (size_t)(end - *at) < (size_t)size) {
+        return FALSE;
+    }
+    *text = *at;
+    *length = (size_t)size;
+    *at += size;
+    return TRUE;
+}
+
+//parses an object of strings and numbers, other values are skipped. returns the number of fields in fields
+//or -1 if the line is not such an object
+int parseJsonObject(char* line, JsonField fields[]) {
+    int count = 0;
+    char* at = line;
+    while (*at == ' ' || *at == '\t') {
+        at++;
+    }
+    if (*at++ != '{') {
+        return -1;
+    }
+    while (TRUE) {
+        while (*at == ' ' || *at == '\t') {
+            at++;
+        }
+        if (*at == '}' && count == 0) {
+            return 0;
+        }
+        JsonField field;
+        if (*at != '"' || (at = parseJsonString(at + 1, &field.key, &field.keyLength)) == NULL) {
+            return -1;
+        }
+        while (*at == ' ' || *at == '\t') {
+            at++;
+        }
+        if (*at++ != ':') {
+            return -1;
+        }
+        while (*at == ' ' || *at == '\t') {
+            at++;
+        }
+        field.isString = FALSE;
+        field.number = 0;
+        field.text = NULL;
+        field.length = 0;
+        if (*at == '"') {
+            if ((at = parseJsonString(at + 1, &field.text, &field.length)) == NULL) {
+                return -1;
+            }
+            field.isString = TRUE;
+        } else if (*at == '-' || (*at >= '0' && *at <= '9')) {
+            field.number = strtoll(at, &at, 10);
+            //a fraction or an exponent is not kept
+            while ((*at >= '0' && *at <= '9') || *at == '.' || *at == 'e' || *at == 'E' || *at == '+' || *at == '-') {
+                at++;
+            }
+        } else if (strncmp(at, "true", 4) == 0 || strncmp(at, "null", 4) == 0) {
+            at += 4;
+        } else if (strncmp(at, "false", 5) == 0) {
+            at += 5;
+        } else {
+            return -1;
+        }
+        if (count < JSON_FIELDS) {
+            fields[count++] = field;
+        }
+        while (*at == ' ' || *at == '\t') {
+            at++;
+        }
+        if (*at == '}') {
+            return count;
+        }
+        if (*at++ != ',') {
+            return -1;
+        }
+    }
+}
+
+//unescapes the string that starts at "at" (after its opening quote) over itself - an escape is never shorter
+//than what it stands for. returns where the string ends, after its closing quote, or NULL if it is not closed
+char* parseJsonString(char* at, char** text, size_t* length) {
+    char* out = at;
+    *text = at;
+    while (*at != '"') {
+        if (*at == '\0') {
+            return NULL;
+        }
+        if (*at != '\\') {
+            *out++ = *at++;
+            continue;
+        }
+        at++;
+        switch (*at) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u':
+            {
+                long code = parseHex4(at + 1);
+                if (code < 0) {
+                    return NULL;
+                }
+                at += 4;
+                //a pair of surrogates is one character
+                if (code >= 0xD800 && code <= 0xDBFF && at[1] == '\\' && at[2] == 'u') {
+                    long low = parseHex4(at + 3);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        at += 6;
+                    }
+                }
+                //the strings end with a '\0', so a '\0' in one is dropped
+                if (code > 0 && code < 0x80) {
+                    *out++ = (char)code;
+                } else if (code > 0 && code < 0x800) {
+                    *out++ = (char)(0xC0 | (code >> 6));
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                } else if (code > 0 && code < 0x10000) {
+                    *out++ = (char)(0xE0 | (code >> 12));
+                    *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                } else if (code > 0) {
+                    *out++ = (char)(0xF0 | (code >> 18));
+                    *out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+                    *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            case '"':
+            case '\\':
+            case '/':
+                *out++ = *at;
+                break;
+            default:
+                return NULL;
+        }
+        at++;
+    }
+    *length = (size_t)(out - *text);
+    return at + 1;
+}
+
+//the value of 4 hex digits, -1 if they are not
+long parseHex4(const char* at) {
+    long value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = at[i];
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10
+            : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+//the first field with the key, NULL if there is none or count is -1
+JsonField* findJsonField(JsonField fields[], int count, const char* key) {
+    size_t length = strlen(key);
+    for (int i = 0; i < count; i++) {
+        if (fields[i].keyLength == length && memcmp(fields[i].key, key, length) == 0) {
+            return &fields[i];
+        }
+    }
+    return NULL;
+}
+
+//writes all the playlists to the file, returns 0 if it can not be written
+int exportLibrary(PlaylistList* playlists, const char* path) {
+    size_t pathLength = strlen(path);
+    Bool json = (pathLength > 6 && strcmp(path + pathLength - 6, ".jsonl") == 0)
+        || (pathLength > 5 && strcmp(path + pathLength - 5, ".json") == 0) ? TRUE : FALSE;
+    FILE* file = fopen(path, json == TRUE ? "w" : "wb");
+    if (file == NULL) {
+        printf("Cannot create %s\n", path);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, EXPORT_BUFFER);
+    double start = secondsNow();
+    long long songs = 0;
+    if (json == FALSE) {
+        fwrite(LIBRARY_MAGIC, 1, LIBRARY_MAGIC_SIZE, file);
+    }
+    for (PlaylistItem* item = playlists->head; item != NULL; item = item->next) {
+        if (json == TRUE) {
+            fputs("{\"playlist\":", file);
+            writeJsonString(file, item->data->name);
+            fputs("}\n", file);
+        } else {
+            int kind = LIBRARY_PLAYLIST;
+            fwrite(&kind, sizeof(int), 1, file);
+            writeBinaryString(file, item->data->name, strlen(item->data->name));
+        }
+        for (SongItem* songItem = item->data->songs->head; songItem != NULL; songItem = songItem->next) {
+            Song* song = songItem->data;
+            if (json == TRUE) {
+                fputs("{\"title\":", file);
+                writeJsonString(file, song->title);
+                fputs(",\"artist\":", file);
+                writeJsonString(file, song->artist);
+                fprintf(file, ",\"year\":%d,\"streams\":%d,\"lyrics\":", song->year, song->streams);
+                writeJsonString(file, song->lyrics->text);
+                fputs("}\n", file);
+            } else {
+                int numbers[3] = {LIBRARY_SONG, song->year, song->streams};
+                fwrite(numbers, sizeof(int), 3, file);
+                writeBinaryString(file, song->title, strlen(song->title));
+                writeBinaryString(file, song->artist, strlen(song->artist));
+                writeBinaryString(file, song->lyrics->text, song->lyrics->size - 1);
+            }
+            songs++;
+        }
+    }
+    if (fclose(file) != 0) {
+        printf("Cannot write %s\n", path);
+        return 0;
+    }
+    printf("Exported %d playlists and %lld songs in %.2f ms\n", playlists->places.count, songs,
+        (secondsNow() - start) * 1e3);
+    return 1;
+}
+
+void writeBinaryString(FILE* file, const char* text, size_t length) {
+    int size = (int)length;
+    fwrite(&size, sizeof(int), 1, file);
+    fwrite(text, 1, length, file);
+}
+
+//writes the string in quotes, with the quotes, backslashes and control characters escaped.
+//the runs of characters that need no escape are written whole
+void writeJsonString(FILE* file, const char* text) {
+    putc('"', file);
+    for (const char* at = text; *at != '\0'; at++) {
+        const char* run = at;
+        while ((unsigned char)*at >= 0x20 && *at != '"' && *at != '\\') {
+            at++;
+        }
+        fwrite(run, 1, (size_t)(at - run), file);
+        if (*at == '\0') {
+            break;
+        }
+        unsigned char c = (unsigned char)*at;
+        if (c == '"' || c == '\\') {
+            putc('\\', file);
+            putc(c, file);
+        } else if (c == '\n') {
+            fputs("\\n", file);
+        } else if (c == '\r') {
+            fputs("\\r", file);
+        } else if (c == '\t') {
+            fputs("\\t", file);
+        } else {
+            fprintf(file, "\\u%04x", c);
+        }
+    }
+    putc('"', file);
+}
+
+//the group of the key, with create a new empty group is made if there is none. NULL if there is no group
+IndexGroup* findGroup(GroupTable* table, uintptr_t key, Bool create) {
+    if (table->count * 10 >= table->capacity * 7) {
+        if (create == FALSE && table->capacity == 0) {
+            return NULL;
+        }
+        growGroupTable(table);
+    }
+    size_t mask = table->capacity - 1;
+    size_t i = (size_t)((unsigned long long)key * 0x9E3779B97F4A7C15ull >> 20) & mask;
+    while (table->groups[i] != NULL) {
+        if (table->groups[i]->key == key) {
+            return table->groups[i];
+        }
+        i = (i + 1) & mask;
+    }
+    if (create == FALSE) {
+        return NULL;
+    }
+    IndexGroup* group = (IndexGroup*)malloc(sizeof(IndexGroup));
+    if (group == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    group->key = key;
+    group->songs = NULL;
+    group->count = 0;
+    group->capacity = 0;
+    group->streams = 0;
+    table->groups[i] = group;
+    table->count++;
+    return group;
+}
+
+//doubles the table, the first call makes it
+void growGroupTable(GroupTable* table) {
+    size_t capacity = table->capacity == 0 ? 256 : table->capacity * 2;
+    IndexGroup** groups = (IndexGroup**)calloc(capacity, sizeof(IndexGroup*));
+    if (groups == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->groups[i] != NULL) {
+            size_t j = (size_t)((unsigned long long)table->groups[i]->key * 0x9E3779B97F4A7C15ull >> 20)
+                & (capacity - 1);
+            while (groups[j] != NULL) {
+                j = (j + 1) & (capacity - 1);
+            }
+            groups[j] = table->groups[i];
+        }
+    }
+    free(table->groups);
+    table->groups = groups;
+    table->capacity = capacity;
+}
+
+//adds the song to the group of its artist, its year and its title
+void indexSong(Song* song, Playlist* playlist) {
+    uintptr_t keys[INDEXES];
+    keys[ARTIST_INDEX] = (uintptr_t)song->artist;
+    keys[YEAR_INDEX] = (uintptr_t)(unsigned)song->year;
+    keys[TITLE_INDEX] = (uintptr_t)song->title;
+    song->playlist = playlist;
+    for (int i = 0; i < INDEXES; i++) {
+        IndexGroup* group = findGroup(&songIndex.tables[i], keys[i], TRUE);
+        if (i == TITLE_INDEX && group->capacity == 0) {
+            //a new title goes to the end of the title order until the next prefix search
+            if (songIndex.titleCount == songIndex.titleCapacity) {
+                songIndex.titleOrder = (IndexGroup**)growItems(songIndex.titleOrder, &songIndex.titleCapacity,
+                    sizeof(IndexGroup*));
+            }
+            songIndex.titleOrder[songIndex.titleCount++] = group;
+        }
+        if (group->count == group->capacity) {
+            group->songs = (Song**)growItems(group->songs, &group->capacity, sizeof(Song*));
+        }
+        song->indexSlots[i] = group->count;
+        group->songs[group->count++] = song;
+        if (i == ARTIST_INDEX) {
+            group->streams += song->streams;
+        }
+    }
+    //an imported song comes with its streams
+    if (sketch.counters != NULL) {
+        addToSketch((uintptr_t)song->title, song->streams);
+    }
+    offerTopSong(song);
+}
+
+//takes the song out of its groups, the last song of a group takes its place.
+//an empty group stays, a title or an artist is never forgotten by the pool either
+void unindexSong(Song* song) {
+    uintptr_t keys[INDEXES];
+    keys[ARTIST_INDEX] = (uintptr_t)song->artist;
+    keys[YEAR_INDEX] = (uintptr_t)(unsigned)song->year;
+    keys[TITLE_INDEX] = (uintptr_t)song->title;
+    for (int i = 0; i < INDEXES; i++) {
+        IndexGroup* group = findGroup(&songIndex.tables[i], keys[i], FALSE);
+        Song* moved = group->songs[--group->count];
+        group->songs[song->indexSlots[i]] = moved;
+        moved->indexSlots[i] = song->indexSlots[i];
+        if (i == ARTIST_INDEX) {
+            group->streams -= song->streams;
+        }
+    }
+    if (sketch.counters != NULL) {
+        addToSketch((uintptr_t)song->title, -(long long)song->streams);
+    }
+    dropTopSong(song);
+}
+
+//sorts the titles that were added since the last time and merges them into the sorted ones
+void sortTitleIndex() {
+    int added = songIndex.titleCount - songIndex.sortedTitles;
+    if (added == 0) {
+        return;
+    }
+    IndexGroup** order = songIndex.titleOrder;
+    qsort(order + songIndex.sortedTitles, (size_t)added, sizeof(IndexGroup*), compareTitleGroups);
+    IndexGroup** merged = (IndexGroup**)malloc((size_t)songIndex.titleCapacity * sizeof(IndexGroup*));
+    if (merged == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+    int i = 0, j = songIndex.sortedTitles, k = 0;
+    while (i < songIndex.sortedTitles || j < songIndex.titleCount) {
+        if (j == songIndex.titleCount
+            || (i < songIndex.sortedTitles && compareTitleGroups(&order[i], &order[j]) <= 0)) {
+            merged[k++] = order[i++];
+        } else {
+            merged[k++] = order[j++];
+        }
+    }
+    free(order);
+    songIndex.titleOrder = merged;
+    songIndex.sortedTitles = songIndex.titleCount;
+}
+
+int compareTitleGroups(const void* group1, const void* group2) {
+    return strcmp((const char*)(*(IndexGroup* const*)group1)->key, (const char*)(*(IndexGroup* const*)group2)->key);
+}
+
+//searches all the playlists by an artist, a decade or the start of a title
+void searchSongs() {
+    int searchTask = -1;
+    int counter = 1;
+    printf("Search by:\n\t1. Artist\n\t2. Decade\n\t3. Title prefix\n");
+    readChoice(&searchTask, 0);
+    switch (searchTask) {
+        case 1:
+        {
+            printf("Artist:\n");
+            char* line = getStringInput();
+            const char* artist = line == NULL ? NULL : findInterned(line, strlen(line));
+            if (artist != NULL) {
+                printFoundSongs(findGroup(&songIndex.tables[ARTIST_INDEX], (uintptr_t)artist, FALSE), &counter);
+            }
+            break;
+        }
+        case 2:
+        {
+            int decade = 0;
+            printf("Decade (like 1990):\n");
+            if (readChoice(&decade, 0) == FALSE) {
+                return;
+            }
+            decade -= decade % 10;
+            for (int year = decade; year < decade + 10; year++) {
+                printFoundSongs(findGroup(&songIndex.tables[YEAR_INDEX], (uintptr_t)(unsigned)year, FALSE), &counter);
+            }
+            break;
+        }
+        case 3:
+        {
+            printf("Title prefix:\n");
+            char* prefix = getStringInput();
+            if (prefix == NULL) {
+                break;
+            }
+            size_t length = strlen(prefix);
+            sortTitleIndex();
+            //the first title that is not before the prefix, the titles with the prefix are all from it on
+            int low = 0, high = songIndex.titleCount;
+            while (low < high) {
+                int middle = low + (high - low) / 2;
+                if (strcmp((const char*)songIndex.titleOrder[middle]->key, prefix) < 0) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            for (int i = low; i < songIndex.titleCount
+                && strncmp((const char*)songIndex.titleOrder[i]->key, prefix, length) == 0; i++) {
+                printFoundSongs(songIndex.titleOrder[i], &counter);
+            }
+            break;
+        }
+        default:
+            return;
+    }
+    if (counter == 1) {
+        printf("No songs found\n");
+    }
+}
+
+void printFoundSongs(const IndexGroup* group, int* counter) {
+    if (group == NULL) {
+        return;
+    }
+    for (int i = 0; i < group->count; i++) {
+        Song* song = group->songs[i];
+        printf("%d. Title: %s\n", *counter, song->title);
+        printf("\tArtist: %s\n" , song->artist);
+        printf("\tReleased: %d\n", song->year);
+        printf("\tStreams: %d\n", song->streams);
+        printf("\tPlaylist: %s\n\n", song->playlist->name);
+        (*counter)++;
+    }
+}
+
+void freeSongIndex() {
+    for (int i = 0; i < INDEXES; i++) {
+        GroupTable* table = &songIndex.tables[i];
+        for (size_t j = 0; j < table->capacity; j++) {
+            if (table->groups[j] != NULL) {
+                free(table->groups[j]->songs);
+                free(table->groups[j]);
+            }
+        }
+        free(table->groups);
+    }
+    free(songIndex.titleOrder);
+}
+
+//adds streams to the song, its artist's total, the sketch and the top songs
+void countStreams(Song* song, int streams) {
+    song->streams += streams;
+    findGroup(&songIndex.tables[ARTIST_INDEX], (uintptr_t)song->artist, FALSE)->streams += streams;
+    if (sketch.counters != NULL) {
+        addToSketch((uintptr_t)song->title, streams);
+    }
+    if (song->inTop == TRUE) {
+        //more streams only move a top song away from the root, it stays a top song
+        siftHeapSong(&topSongs.top, song->heapSlot);
+        return;
+    }
+    siftHeapSong(&topSongs.rest, song->heapSlot);
+    SongHeap* top = &topSongs.top;
+    SongHeap* rest = &topSongs.rest;
+    if (top->count > 0 && streamsBefore(top->songs[0], rest->songs[0]) == TRUE) {
+        Song* lowest = removeHeapSong(top, 0);
+        pushHeapSong(top, removeHeapSong(rest, 0));
+        pushHeapSong(rest, lowest);
+    }
+}
+
+//TRUE if song1 is less streamed than song2, the newer song is less for the same streams
+Bool streamsBefore(const Song* song1, const Song* song2) {
+    if (song1->streams != song2->streams) {
+        return song1->streams < song2->streams ? TRUE : FALSE;
+    }
+    return song1->id > song2->id ? TRUE : FALSE;
+}
+
+//the min heap has the lower song first, the max heap the higher one
+Bool heapBefore(const SongHeap* heap, const Song* song1, const Song* song2) {
+    return heap->top == TRUE ? streamsBefore(song1, song2) : streamsBefore(song2, song1);
+}
+
+void swapHeapSongs(SongHeap* heap, int slot1, int slot2) {
+    Song* song = heap->songs[slot1];
+    heap->songs[slot1] = heap->songs[slot2];
+    heap->songs[slot2] = song;
+    heap->songs[slot1]->heapSlot = slot1;
+    heap->songs[slot2]->heapSlot = slot2;
+}
+
+//moves the song of the slot up or down the heap to its place
+void siftHeapSong(SongHeap* heap, int slot) {
+    while (slot > 0 && heapBefore(heap, heap->songs[slot], heap->songs[(slot - 1) / 2]) == TRUE) {
+        swapHeapSongs(heap, slot, (slot - 1) / 2);
+        slot = (slot - 1) / 2;
+    }
+    while (2 * slot + 1 < heap->count) {
+        int child = 2 * slot + 1;
+        if (child + 1 < heap->count && heapBefore(heap, heap->songs[child + 1], heap->songs[child]) == TRUE) {
+            child++;
+        }
+        if (heapBefore(heap, heap->songs[child], heap->songs[slot]) == FALSE) {
+            break;
+        }
+        swapHeapSongs(heap, slot, child);
+        slot = child;
+    }
+}
+
+void pushHeapSong(SongHeap* heap, Song* song) {
+    if (heap->count == heap->capacity) {
+        heap->songs = (Song**)growItems(heap->songs, &heap->capacity, sizeof(Song*));
+    }
+    song->heapSlot = heap->count;
+    song->inTop = heap->top;
+    heap->songs[heap->count++] = song;
+    siftHeapSong(heap, song->heapSlot);
+}
+
+//takes the song in the slot out of the heap, the last song of the heap takes its place
+Song* removeHeapSong(SongHeap* heap, int slot) {
+    Song* song = heap->songs[slot];
+    heap->count--;
+    if (slot != heap->count) {
+        swapHeapSongs(heap, slot, heap->count);
+        siftHeapSong(heap, slot);
+    }
+    song->heapSlot = -1;
+    return song;
+}
+
+//a new song goes to the top songs if there is room or if it beats the least streamed of them,
+//which goes to the rest instead
+void offerTopSong(Song* song) {
+    SongHeap* top = &topSongs.top;
+    if (top->count < TOP_SONGS) {
+        pushHeapSong(top, song);
+    } else if (streamsBefore(top->songs[0], song) == TRUE) {
+        Song* lowest = removeHeapSong(top, 0);
+        pushHeapSong(top, song);
+        pushHeapSong(&topSongs.rest, lowest);
+    } else {
+        pushHeapSong(&topSongs.rest, song);
+    }
+}
+
+//a deleted top song leaves its place to the most streamed song of the rest
+void dropTopSong(Song* song) {
+    if (song->heapSlot < 0) {
+        return;
+    }
+    if (song->inTop == FALSE) {
+        removeHeapSong(&topSongs.rest, song->heapSlot);
+        return;
+    }
+    removeHeapSong(&topSongs.top, song->heapSlot);
+    if (topSongs.rest.count > 0) {
+        pushHeapSong(&topSongs.top, removeHeapSong(&topSongs.rest, 0));
+    }
+}
+
+void freeTopSongs() {
+    free(topSongs.top.songs);
+    free(topSongs.rest.songs);
+}
+
+//the most streamed song first
+int compareTopSongs(const void* song1, const void* song2) {
+    return streamsBefore(*(Song* const*)song2, *(Song* const*)song1) == TRUE ? -1 : 1;
+}
+
+//prints the heap in order, it only sorts the TOP_SONGS songs of the heap and not the library
+void printTopSongs() {
+    if (topSongs.top.count == 0) {
+        printf("No songs found\n");
+        return;
+    }
+    Song* order[TOP_SONGS];
+    memcpy(order, topSongs.top.songs, (size_t)topSongs.top.count * sizeof(Song*));
+    qsort(order, (size_t)topSongs.top.count, sizeof(Song*), compareTopSongs);
+    for (int i = 0; i < topSongs.top.count; i++) {
+        printf("%d. %s - %s (%d streams, %s)\n", i + 1, order[i]->title, order[i]->artist, order[i]->streams,
+            order[i]->playlist->name);
+    }
+}
+
+//the width is rounded up to a power of two
+void initSketch(size_t width) {
+    sketch.width = 1;
+    while (sketch.width < width) {
+        sketch.width *= 2;
+    }
+    sketch.counters = (long long*)calloc(SKETCH_DEPTH * sketch.width, sizeof(long long));
+    if (sketch.counters == NULL) {
+        printf("Memory allocation error\n");
+        exit(1);
+    }
+}
+
+//each row mixes the key with its own odd multiplier
+size_t sketchColumn(uintptr_t key, int row) {
+    static const unsigned long long multipliers[SKETCH_DEPTH] = {
+        0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull
+    };
+    unsigned long long mixed = (unsigned long long)key * multipliers[row];
+    return (size_t)(mixed ^ (mixed >> 32)) & (sketch.width - 1);
+}
+
+void addToSketch(uintptr_t key, long long count) {
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        sketch.counters[row * sketch.width + sketchColumn(key, row)] += count;
+    }
+}
+
+long long sketchCount(uintptr_t key) {
+    long long count = sketch.counters[sketchColumn(key, 0)];
+    for (int row = 1; row < SKETCH_DEPTH; row++) {
+        long long counter = sketch.counters[row * sketch.width + sketchColumn(key, row)];
+        if (counter < count) {
+            count = counter;
+        }
+    }
+    return count;
+}
+
+//the top songs, the streams of an artist, or the sketch's streams of a title
+void streamsAnalytics() {
+    int analyticsTask = -1;
+    printf("Streams analytics:\n\t1. Top %d songs\n\t2. Artist streams\n\t3. Title streams (sketch)\n", TOP_SONGS);
+    readChoice(&analyticsTask, 0);
+    switch (analyticsTask) {
+        case 1:
+            printTopSongs();
+            break;
+        case 2:
+        {
+            printf("Artist:\n");
+            char* line = getStringInput();
+            const char* artist = line == NULL ? NULL : findInterned(line, strlen(line));
+            IndexGroup* group = artist == NULL ? NULL
+                : findGroup(&songIndex.tables[ARTIST_INDEX], (uintptr_t)artist, FALSE);
+            if (group == NULL || group->count == 0) {
+                printf("No songs found\n");
+            } else {
+                printf("%s: %lld streams in %d songs\n", artist, group->streams, group->count);
+            }
+            break;
+        }
+        case 3:
+        {
+            if (sketch.counters == NULL) {
+                printf("The sketch is off, run with --sketch <width>\n");
+                break;
+            }
+            printf("Title:\n");
+            char* line = getStringInput();
+            const char* title = line == NULL ? NULL : findInterned(line, strlen(line));
+            printf("About %lld streams\n", title == NULL ? 0 : sketchCount((uintptr_t)title));
+            break;
+        }
+        default:
+            break;
     }
-    printf("sorted\n");
 }
 
+//4 stays exit so the inputs written for the original menu still work, new options come after it
 void printPlaylistsMenu() {
     printf("Please Choose:\n");
-    printf("\t1. Watch playlists\n\t2. Add playlist\n\t3. Remove playlist\n\t4. exit\n");
+    printf("\t1. Watch playlists\n\t2. Add playlist\n\t3. Remove playlist\n\t4. exit\n\t5. Search songs\n"
+        "\t6. Streams analytics\n");
 }
 
 void printSongsMenu() {